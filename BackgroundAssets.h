@@ -0,0 +1,17 @@
+#ifndef BACKGROUNDASSETS_H
+#define BACKGROUNDASSETS_H
+
+#include <QtGlobal>
+
+// Background pixels prepared at build time by tools/AssetTool.cpp, one entry
+// per configured display resolution. Rows are tightly packed RGB32; the
+// list ends with a null entry.
+struct BackgroundAsset {
+    int width;
+    int height;
+    const uchar *pixels;
+};
+
+extern const BackgroundAsset BACKGROUND_ASSETS[];
+
+#endif // BACKGROUNDASSETS_H
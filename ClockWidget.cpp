@@ -0,0 +1,241 @@
+#include "ClockWidget.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include <QElapsedTimer>
+#include <QEvent>
+#include <QFontMetrics>
+#include <QPaintEvent>
+#include <QPainter>
+#include <QtMath>
+
+namespace {
+static const int TIME_POINT_SIZE = 72;
+static const int SMALL_POINT_SIZE = 24;
+static const int DATE_POINT_SIZE = 18;
+static const int SIDE_MARGIN_LEFT = 5;
+static const int SIDE_MARGIN_TOP = 15;
+// Antialiased glyphs may bleed slightly outside their advance
+static const int GLYPH_BLEED = 2;
+}
+
+ClockWidget::ClockWidget(QWidget *parent)
+    : QWidget(parent)
+{
+    // Every pixel is drawn from the cached background, so Qt does not need
+    // to repaint the window beneath us
+    setAttribute(Qt::WA_OpaquePaintEvent);
+
+    segments[TIME].alignment = Qt::AlignLeft | Qt::AlignVCenter;
+    segments[SECONDS].alignment = Qt::AlignHCenter | Qt::AlignBottom;
+    segments[PERIOD].alignment = Qt::AlignHCenter | Qt::AlignTop;
+    segments[DATE].alignment = Qt::AlignHCenter | Qt::AlignTop;
+
+    for (Segment &segment : segments) {
+        segment.staticText.setTextFormat(Qt::PlainText);
+    }
+
+    setFontFamily(font().family());
+}
+
+void ClockWidget::setFontFamily(const QString &family)
+{
+    segments[TIME].font = QFont(family, TIME_POINT_SIZE);
+    segments[SECONDS].font = QFont(family, SMALL_POINT_SIZE);
+    segments[PERIOD].font = QFont(family, SMALL_POINT_SIZE);
+    segments[DATE].font = QFont(family, DATE_POINT_SIZE);
+
+    for (Segment &segment : segments) {
+        segment.staticText.prepare(QTransform(), segment.font);
+    }
+
+    layoutSegments();
+    updateGeometry();
+    update();
+}
+
+void ClockWidget::setDateTime(const QDateTime &dateTime)
+{
+    const QTime time = dateTime.time();
+    const int hour12 = (time.hour() % 12 == 0) ? 12 : time.hour() % 12;
+
+    setSegmentText(TIME, QString::number(hour12) + ":" + time.toString("mm"));
+    setSegmentText(SECONDS, time.toString("ss"));
+    setSegmentText(PERIOD, time.toString("AP"));
+    setSegmentText(DATE, dateTime.toString("dddd, MMMM dd"));
+}
+
+const ClockWidget::PaintStats &ClockWidget::paintStats() const
+{
+    return stats;
+}
+
+QSize ClockWidget::sizeHint() const
+{
+    QFontMetrics timeMetrics(segments[TIME].font);
+    QFontMetrics smallMetrics(segments[SECONDS].font);
+    QFontMetrics dateMetrics(segments[DATE].font);
+
+    int width = timeMetrics.horizontalAdvance("12:00") + SIDE_MARGIN_LEFT
+                + qMax(smallMetrics.horizontalAdvance("00"), smallMetrics.horizontalAdvance("PM"));
+    return QSize(width, timeMetrics.height() + dateMetrics.height());
+}
+
+void ClockWidget::paintEvent(QPaintEvent *event)
+{
+    QElapsedTimer timer;
+    timer.start();
+    Trace::Span span("ClockWidget::paintEvent", "paint");
+
+    if (backgroundDirty) {
+        renderBackground();
+    }
+
+    QPainter painter(this);
+    const QRegion &region = event->region();
+    for (const QRect &rect : region) {
+        painter.drawPixmap(rect, background, rect);
+    }
+
+    painter.setPen(Qt::white);
+    for (const Segment &segment : segments) {
+        if (segment.text.isEmpty() || !region.intersects(segment.rect.adjusted(-GLYPH_BLEED, 0, GLYPH_BLEED, 0))) {
+            continue;
+        }
+        painter.setFont(segment.font);
+        painter.drawStaticText(segment.origin, segment.staticText);
+    }
+
+    static Metrics::Histogram &paintDuration = Metrics::histogram(
+        "pidashboard_clock_paint_duration_seconds", "Time spent in ClockWidget::paintEvent.");
+    quint64 elapsed = timer.nsecsElapsed();
+    paintDuration.observeNs(elapsed);
+    stats.paints++;
+    stats.totalNs += elapsed;
+    stats.maxNs = qMax(stats.maxNs, elapsed);
+}
+
+void ClockWidget::resizeEvent(QResizeEvent *event)
+{
+    backgroundDirty = true;
+    layoutSegments();
+    QWidget::resizeEvent(event);
+}
+
+void ClockWidget::moveEvent(QMoveEvent *event)
+{
+    backgroundDirty = true;
+    QWidget::moveEvent(event);
+}
+
+void ClockWidget::changeEvent(QEvent *event)
+{
+    if (event->type() == QEvent::PaletteChange) {
+        backgroundDirty = true;
+        update();
+    }
+    QWidget::changeEvent(event);
+}
+
+void ClockWidget::setSegmentText(SegmentIndex index, const QString &text)
+{
+    Segment &segment = segments[index];
+    if (segment.text == text) {
+        return;
+    }
+
+    QFontMetrics metrics(segment.font);
+    const QString previous = segment.text;
+    const bool sameShape = previous.size() == text.size()
+                           && metrics.horizontalAdvance(previous) == metrics.horizontalAdvance(text);
+
+    QRegion dirty;
+    if (sameShape) {
+        for (int i = 0; i < text.size(); ++i) {
+            if (previous.at(i) != text.at(i)) {
+                dirty += characterRect(segment, i);
+            }
+        }
+    }
+
+    segment.text = text;
+    segment.staticText.setText(text);
+    segment.staticText.prepare(QTransform(), segment.font);
+
+    if (sameShape) {
+        // Same glyph positions, so only the changed characters need painting
+        update(dirty);
+    } else if (index == DATE) {
+        update(segment.rect);
+        placeText(segment);
+        update(segment.rect);
+    } else {
+        // A wider or narrower time moves the seconds and period as well
+        layoutSegments();
+        update();
+    }
+}
+
+void ClockWidget::layoutSegments()
+{
+    QFontMetrics timeMetrics(segments[TIME].font);
+    QFontMetrics smallMetrics(segments[SECONDS].font);
+    QFontMetrics dateMetrics(segments[DATE].font);
+
+    const int timeWidth = timeMetrics.horizontalAdvance(segments[TIME].text);
+    const int timeHeight = timeMetrics.height();
+    segments[TIME].rect = QRect(0, 0, timeWidth, timeHeight);
+
+    const int sideX = timeWidth + SIDE_MARGIN_LEFT;
+    const int sideWidth = qMax(smallMetrics.horizontalAdvance(segments[SECONDS].text),
+                               smallMetrics.horizontalAdvance(segments[PERIOD].text));
+    const int sideHeight = (timeHeight - SIDE_MARGIN_TOP) / 2;
+    segments[SECONDS].rect = QRect(sideX, SIDE_MARGIN_TOP, sideWidth, sideHeight);
+    segments[PERIOD].rect = QRect(sideX, SIDE_MARGIN_TOP + sideHeight, sideWidth,
+                                  timeHeight - SIDE_MARGIN_TOP - sideHeight);
+
+    segments[DATE].rect = QRect(0, timeHeight, width(), dateMetrics.height());
+
+    for (Segment &segment : segments) {
+        placeText(segment);
+    }
+}
+
+void ClockWidget::placeText(Segment &segment)
+{
+    QFontMetrics metrics(segment.font);
+    const QRect &rect = segment.rect;
+    const int textWidth = metrics.horizontalAdvance(segment.text);
+    const int textHeight = metrics.height();
+
+    qreal x = rect.left();
+    if (segment.alignment & Qt::AlignHCenter) {
+        x += (rect.width() - textWidth) / 2.0;
+    }
+
+    qreal y = rect.top();
+    if (segment.alignment & Qt::AlignBottom) {
+        y += rect.height() - textHeight;
+    } else if (segment.alignment & Qt::AlignVCenter) {
+        y += (rect.height() - textHeight) / 2.0;
+    }
+
+    segment.origin = QPointF(x, y);
+}
+
+QRect ClockWidget::characterRect(const Segment &segment, int index) const
+{
+    QFontMetrics metrics(segment.font);
+    int x = qFloor(segment.origin.x()) + metrics.horizontalAdvance(segment.text.left(index));
+    int width = metrics.horizontalAdvance(segment.text.at(index));
+    return QRect(x - GLYPH_BLEED, qFloor(segment.origin.y()), width + 2 * GLYPH_BLEED + 1, metrics.height() + 1);
+}
+
+void ClockWidget::renderBackground()
+{
+    // Same brush and origin the window uses, rendered once for our rect
+    background = QPixmap(size());
+    QPainter painter(&background);
+    painter.setBrushOrigin(-mapTo(window(), QPoint(0, 0)));
+    painter.fillRect(background.rect(), window()->palette().brush(QPalette::Window));
+    backgroundDirty = false;
+}
@@ -0,0 +1,74 @@
+#ifndef CLOCKWIDGET_H
+#define CLOCKWIDGET_H
+
+#include <QWidget>
+#include <QDateTime>
+#include <QFont>
+#include <QPixmap>
+#include <QStaticText>
+
+// Custom-painted clock showing time, seconds, AM/PM and date. The window
+// background behind the widget is rendered into a cache once, glyph layout
+// is cached in QStaticText, and a tick only repaints the characters that
+// changed, so the date is redrawn only when the day changes.
+class ClockWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    // Accumulated paint cost, to verify that ticks stay cheap
+    struct PaintStats {
+        quint64 paints = 0;
+        quint64 totalNs = 0;
+        quint64 maxNs = 0;
+    };
+
+    explicit ClockWidget(QWidget *parent = nullptr);
+
+    void setFontFamily(const QString &family);
+
+    // Shows the given time, invalidating only what changed
+    void setDateTime(const QDateTime &dateTime);
+
+    const PaintStats &paintStats() const;
+
+    QSize sizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void moveEvent(QMoveEvent *event) override;
+    void changeEvent(QEvent *event) override;
+
+private:
+    // One independently updated piece of text
+    struct Segment {
+        QString text;
+        QStaticText staticText;
+        QFont font;
+        QRect rect;
+        Qt::Alignment alignment;
+        QPointF origin;
+    };
+
+    enum SegmentIndex {
+        TIME,
+        SECONDS,
+        PERIOD,
+        DATE,
+        SEGMENT_COUNT
+    };
+
+    Segment segments[SEGMENT_COUNT];
+    QPixmap background;
+    bool backgroundDirty = true;
+    PaintStats stats;
+
+    void setSegmentText(SegmentIndex index, const QString &text);
+    void layoutSegments();
+    void placeText(Segment &segment);
+    QRect characterRect(const Segment &segment, int index) const;
+    void renderBackground();
+};
+
+#endif // CLOCKWIDGET_H
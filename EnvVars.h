@@ -0,0 +1,23 @@
+#ifndef ENVVARS_H
+#define ENVVARS_H
+
+#include <QString>
+#include <map>
+
+// Lookups in the variables read from the env file, with a fallback for
+// missing or unusable values
+inline QString envString(const std::map<QString, QString> &envVars, const QString &key, const QString &fallback)
+{
+    auto it = envVars.find(key);
+    return it != envVars.end() && !it->second.isEmpty() ? it->second : fallback;
+}
+
+inline int envInt(const std::map<QString, QString> &envVars, const QString &key, int fallback)
+{
+    auto it = envVars.find(key);
+    bool ok = false;
+    int value = it != envVars.end() ? it->second.toInt(&ok) : 0;
+    return ok ? value : fallback;
+}
+
+#endif // ENVVARS_H
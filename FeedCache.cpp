@@ -0,0 +1,91 @@
+#include "FeedCache.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace {
+static const quint32 CACHE_MAGIC = 0x50444643; // "PDFC"
+static const quint32 CACHE_VERSION = 2;
+}
+
+FeedCache::FeedCache(const QString &directory)
+    : dir(directory)
+{
+    if (dir.isEmpty()) {
+        dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/feeds";
+    }
+    QDir().mkpath(dir);
+}
+
+FeedCache::Entry FeedCache::load(const QUrl &url) const
+{
+    Entry entry;
+    QFile file(pathFor(url));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return entry;
+    }
+
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if (magic != CACHE_MAGIC || version != CACHE_VERSION) {
+        return entry;
+    }
+
+    in >> entry.etag >> entry.lastModified >> entry.body >> entry.itemLimit;
+    if (in.status() != QDataStream::Ok) {
+        return Entry();
+    }
+    return entry;
+}
+
+bool FeedCache::store(const QUrl &url, const Entry &entry) const
+{
+    QSaveFile file(pathFor(url));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    QDataStream out(&file);
+    out << CACHE_MAGIC << CACHE_VERSION << entry.etag << entry.lastModified << entry.body << entry.itemLimit;
+    return file.commit();
+}
+
+void FeedCache::applyValidators(QNetworkRequest &request, const Entry &entry)
+{
+    if (!entry.isValid()) {
+        return;
+    }
+    if (!entry.etag.isEmpty()) {
+        request.setRawHeader("If-None-Match", entry.etag);
+    }
+    if (!entry.lastModified.isEmpty()) {
+        request.setRawHeader("If-Modified-Since", entry.lastModified);
+    }
+}
+
+FeedCache::Entry FeedCache::fromReply(const QNetworkReply *reply, const QByteArray &body)
+{
+    Entry entry;
+    entry.etag = reply->rawHeader("ETag");
+    entry.lastModified = reply->rawHeader("Last-Modified");
+    entry.body = body;
+    return entry;
+}
+
+FeedCache::Stats &FeedCache::stats()
+{
+    static Stats instance;
+    return instance;
+}
+
+QString FeedCache::pathFor(const QUrl &url) const
+{
+    // URLs carry API keys, so only a hash of them ends up on disk
+    QByteArray key = QCryptographicHash::hash(url.toEncoded(), QCryptographicHash::Sha1).toHex();
+    return dir + "/" + QString::fromLatin1(key) + ".feed";
+}
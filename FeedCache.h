@@ -0,0 +1,58 @@
+#ifndef FEEDCACHE_H
+#define FEEDCACHE_H
+
+#include <QByteArray>
+#include <QString>
+#include <QUrl>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+
+// Persistent on-disk cache of feed responses used for conditional GETs
+class FeedCache
+{
+public:
+    // A cached response body together with its HTTP validators
+    struct Entry {
+        QByteArray etag;
+        QByteArray lastModified;
+        QByteArray body;
+        // Item limit the body was cut short at, 0 for a complete document
+        qint32 itemLimit = 0;
+
+        bool isValid() const { return !body.isEmpty(); }
+
+        // A cut short body only reproduces the items for limits up to its own
+        bool servesLimit(int limit) const { return itemLimit <= 0 || (limit > 0 && limit <= itemLimit); }
+    };
+
+    // Process-wide cache counters
+    struct Stats {
+        quint64 hits = 0;
+        quint64 misses = 0;
+        quint64 bytesSaved = 0;
+    };
+
+    // Uses the platform cache location when no directory is given
+    explicit FeedCache(const QString &directory = QString());
+
+    // Reads the entry stored for the given URL, invalid if there is none
+    Entry load(const QUrl &url) const;
+
+    // Atomically writes the entry for the given URL
+    bool store(const QUrl &url, const Entry &entry) const;
+
+    // Adds If-None-Match / If-Modified-Since headers from the entry
+    static void applyValidators(QNetworkRequest &request, const Entry &entry);
+
+    // Builds an entry from the validators of a reply and its body
+    static Entry fromReply(const QNetworkReply *reply, const QByteArray &body);
+
+    static Stats &stats();
+
+private:
+    QString dir;
+
+    QString pathFor(const QUrl &url) const;
+};
+
+#endif // FEEDCACHE_H
@@ -0,0 +1,94 @@
+#include "FeedFetcher.h"
+#include "EnvVars.h"
+#include <QDebug>
+#include <QStandardPaths>
+
+namespace {
+static const int OW_DEFAULT_DAILY_QUOTA = 1000;
+static const int W_DEFAULT_DAILY_QUOTA = 30000;
+static const int IDLE_DEFAULT_POLL_MINUTES = 120;
+
+static const char *DEFAULT_NEWS_URL = "https://feeds.bbci.co.uk/news/world/rss.xml";
+}
+
+FeedFetcher::FeedFetcher(const std::map<QString, QString> &envVars, QObject *parent)
+    : QObject(parent),
+    weatherReader(this),
+    forecastReader(this),
+    scheduler(this)
+{
+    // Every endpoint can be pointed elsewhere, e.g. at a local fixture server.
+    // NEWS_URL may list several RSS or Atom feeds separated by commas.
+    for (const QString &url : envString(envVars, "NEWS_URL", DEFAULT_NEWS_URL).split(',', Qt::SkipEmptyParts)) {
+        newsUrls.append(QUrl(url.trimmed()));
+    }
+    weatherUrl = QUrl(envString(envVars, "WEATHER_URL", QString("https://api.openweathermap.org/data/2.5/weather?zip=%1&mode=xml&units=%2&appid=%3").arg(
+        envVars.at("ZIP"),
+        envVars.at("UNIT"),
+        envVars.at("OW_API_KEY")
+    )));
+    forecastUrl = QUrl(envString(envVars, "FORECAST_URL", QString("https://api.weatherapi.com/v1/forecast.xml?key=%1&q=%2&days=3").arg(
+        envVars.at("W_API_KEY"),
+        envVars.at("ZIP").split(",")[0]
+    )));
+
+    // One reader per news source, all fetched concurrently
+    for (int source = 0; source < newsUrls.size(); ++source) {
+        XmlReader *reader = new XmlReader(this);
+        newsReaders.append(reader);
+        const QString name = newsUrls.size() == 1 ? QString("news") : QString("news%1").arg(source + 1);
+        addFeed(*reader, name, newsUrls[source], XmlType::NEWS, source, NEWS_MAX_ITEMS, NEWS_FIELDS);
+    }
+    addFeed(weatherReader, "weather", weatherUrl, XmlType::WEATHER, 0);
+    addFeed(forecastReader, "forecast", forecastUrl, XmlType::FORECAST, 0);
+
+    // Keep within the API plans of the weather providers, also across restarts
+    scheduler.setStateFile(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/budgets.state");
+    scheduler.setProviderBudget(weatherUrl.host(), envInt(envVars, "OW_DAILY_QUOTA", OW_DEFAULT_DAILY_QUOTA));
+    scheduler.setProviderBudget(forecastUrl.host(), envInt(envVars, "W_DAILY_QUOTA", W_DEFAULT_DAILY_QUOTA));
+
+    idlePollMs = envInt(envVars, "IDLE_POLL_MINUTES", IDLE_DEFAULT_POLL_MINUTES) * 60 * 1000LL;
+}
+
+void FeedFetcher::start()
+{
+    scheduler.start();
+}
+
+int FeedFetcher::newsSourceCount() const
+{
+    return newsReaders.size();
+}
+
+void FeedFetcher::setIdle(bool idle)
+{
+    scheduler.setMinimumInterval(idle ? idlePollMs : 0);
+}
+
+quint64 FeedFetcher::deferredFetches() const
+{
+    return scheduler.deferredFetches();
+}
+
+void FeedFetcher::addFeed(XmlReader &reader, const QString &name, const QUrl &url, XmlType type, int source,
+                          int itemLimit, FeedFields fields)
+{
+    const int feed = scheduler.addFeed(name, url.host(), [this, &reader, url, type, itemLimit, fields]() {
+        emit fetchStarted();
+        reader.loadFeed(url, type, itemLimit, fields);
+    });
+
+    connect(&reader, &XmlReader::feedLoaded, this, [this, &reader, feed, type, source]() {
+        scheduler.reportSuccess(feed, reader.freshnessSeconds());
+        emit resultLoaded(type, source, reader.getResult());
+    });
+    connect(&reader, &XmlReader::feedNotModified, this, [this, &reader, feed]() {
+        scheduler.reportSuccess(feed, reader.freshnessSeconds());
+    });
+
+    // Keep the last good data and let the scheduler retry
+    connect(&reader, &XmlReader::errorOccurred, this, [this, feed, name](const QString &error) {
+        qInfo() << "Error loading" << name << "feed:" << error;
+        scheduler.reportError(feed);
+    });
+}
@@ -0,0 +1,57 @@
+#ifndef FEEDFETCHER_H
+#define FEEDFETCHER_H
+
+#include <QObject>
+#include <QList>
+#include <QUrl>
+#include <map>
+#include "FeedParser.h"
+#include "FeedScheduler.h"
+#include "XmlReader.h"
+
+// Fetches and parses the news, weather and forecast feeds on the
+// FeedScheduler's timetable, without any GUI. MainWindow uses it directly;
+// in daemon mode a FeedPublisher shares its results with many dashboards.
+class FeedFetcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int NEWS_MAX_ITEMS = 8;
+
+    explicit FeedFetcher(const std::map<QString, QString> &envVars, QObject *parent = nullptr);
+
+    // Fetches every feed now, then keeps following the schedule
+    void start();
+
+    int newsSourceCount() const;
+
+    // Polls at the long idle interval instead of the advertised freshness
+    void setIdle(bool idle);
+
+    // Fetches skipped so far while idle
+    quint64 deferredFetches() const;
+
+signals:
+    // Emitted right before a request is sent
+    void fetchStarted();
+
+    // Emitted with each newly parsed document; source is the index of the
+    // news feed and 0 for weather and forecast
+    void resultLoaded(XmlType type, int source, const FeedResult &result);
+
+private:
+    QList<XmlReader *> newsReaders;
+    XmlReader weatherReader;
+    XmlReader forecastReader;
+    FeedScheduler scheduler;
+    QList<QUrl> newsUrls;
+    QUrl weatherUrl;
+    QUrl forecastUrl;
+    qint64 idlePollMs;
+
+    void addFeed(XmlReader &reader, const QString &name, const QUrl &url, XmlType type, int source,
+                 int itemLimit = 0, FeedFields fields = ALL_FEED_FIELDS);
+};
+
+#endif // FEEDFETCHER_H
@@ -0,0 +1,314 @@
+#include "FeedParser.h"
+
+namespace {
+// Compile-time element name table entry
+struct TagName {
+    const char *name;
+    int size;
+    FeedTag tag;
+};
+
+template <int N>
+constexpr TagName tagName(const char (&name)[N], FeedTag tag)
+{
+    return {name, N - 1, tag};
+}
+
+// RSS 2.0 and Atom share one table; the names do not clash
+constexpr TagName NEWS_TAGS[] = {
+    tagName("item", FeedTag::ItemBoundary),
+    tagName("entry", FeedTag::ItemBoundary),
+    tagName("title", FeedTag::Title),
+    tagName("link", FeedTag::Link),
+    tagName("description", FeedTag::Description),
+    tagName("summary", FeedTag::Description),
+    tagName("pubDate", FeedTag::PubDate),
+    tagName("published", FeedTag::PubDate),
+    tagName("updated", FeedTag::PubDate),
+    tagName("guid", FeedTag::Guid),
+    tagName("id", FeedTag::Guid),
+    tagName("ttl", FeedTag::Ttl)
+};
+
+constexpr TagName WEATHER_TAGS[] = {
+    tagName("current", FeedTag::ItemBoundary),
+    tagName("temperature", FeedTag::Temperature),
+    tagName("feels_like", FeedTag::FeelsLike),
+    tagName("weather", FeedTag::Weather)
+};
+
+constexpr TagName FORECAST_TAGS[] = {
+    tagName("forecastday", FeedTag::ItemOpen),
+    tagName("day", FeedTag::ItemClose),
+    tagName("maxtemp_c", FeedTag::MaxTemp),
+    tagName("mintemp_c", FeedTag::MinTemp),
+    tagName("date", FeedTag::Date),
+    tagName("daily_chance_of_rain", FeedTag::RainChance),
+    tagName("icon", FeedTag::Icon)
+};
+
+template <size_t N>
+FeedTag lookup(const TagName (&table)[N], const QStringRef &name)
+{
+    // The length check rejects almost every irrelevant element before any
+    // character is compared, and nothing here allocates
+    for (const TagName &entry : table) {
+        if (entry.size == name.size() && name == QLatin1String(entry.name, entry.size)) {
+            return entry.tag;
+        }
+    }
+    return FeedTag::None;
+}
+
+// Tags carrying item data, as opposed to structure and refresh hints
+bool isItemField(FeedTag tag)
+{
+    return tag >= FeedTag::Title && tag != FeedTag::Ttl;
+}
+
+FeedTag classify(XmlType type, const QStringRef &name)
+{
+    switch (type) {
+    case XmlType::NEWS: return lookup(NEWS_TAGS, name);
+    case XmlType::WEATHER: return lookup(WEATHER_TAGS, name);
+    case XmlType::FORECAST: return lookup(FORECAST_TAGS, name);
+    }
+    return FeedTag::None;
+}
+}
+
+int FeedResult::itemCount() const
+{
+    if (news) {
+        return int(news->items.size());
+    }
+    if (forecast) {
+        return forecast->count;
+    }
+    return weather ? 1 : 0;
+}
+
+FeedParser::FeedParser(XmlType type, int itemLimit, FeedFields fields)
+{
+    reset(type, itemLimit, fields);
+}
+
+void FeedParser::reset(XmlType newType, int newItemLimit, FeedFields newFields)
+{
+    xml.clear();
+    type = newType;
+    itemLimit = newItemLimit;
+    fields = newFields;
+    status = NeedMoreData;
+    news.reset();
+    weather.reset();
+    forecast.reset();
+    switch (type) {
+    case XmlType::NEWS: news = std::make_shared<NewsFeed>(); break;
+    case XmlType::WEATHER: weather = std::make_shared<CurrentWeather>(); break;
+    case XmlType::FORECAST: forecast = std::make_shared<Forecast>(); break;
+    }
+    inItem = false;
+    newsItem = NewsItem();
+    forecastItem = ForecastItem();
+    ttl.clear();
+    field = nullptr;
+    skipDepth = 0;
+}
+
+FeedParser::Status FeedParser::addData(const QByteArray &chunk)
+{
+    if (status != NeedMoreData) {
+        return status;
+    }
+
+    xml.addData(chunk);
+    return parse();
+}
+
+FeedParser::Status FeedParser::finish()
+{
+    if (status == NeedMoreData) {
+        status = Error;
+    }
+    return status;
+}
+
+FeedResult FeedParser::takeResult()
+{
+    FeedResult result;
+    result.news = std::move(news);
+    result.weather = std::move(weather);
+    result.forecast = std::move(forecast);
+    return result;
+}
+
+int FeedParser::ttlMinutes() const
+{
+    return ttl.trimmed().toInt();
+}
+
+QString FeedParser::errorString() const
+{
+    if (status == Error && !xml.hasError()) {
+        return "Premature end of document.";
+    }
+    return xml.errorString();
+}
+
+FeedParser::Status FeedParser::parse()
+{
+    // readElementText() cannot resume across chunks, so element text is
+    // collected from Characters tokens instead
+    while (!xml.atEnd()) {
+        QXmlStreamReader::TokenType token = xml.readNext();
+
+        // skipCurrentElement() cannot resume across chunks either, so
+        // skipped subtrees are tracked by depth and their tokens dropped
+        if (skipDepth > 0) {
+            if (token == QXmlStreamReader::StartElement) {
+                skipDepth++;
+            } else if (token == QXmlStreamReader::EndElement) {
+                skipDepth--;
+            }
+            continue;
+        }
+
+        if (token == QXmlStreamReader::StartElement) {
+            startElement(classify(type, xml.name()));
+        } else if (token == QXmlStreamReader::Characters) {
+            if (field) {
+                field->append(xml.text());
+            }
+        } else if (token == QXmlStreamReader::EndElement) {
+            endElement(classify(type, xml.name()));
+        }
+
+        if (status == LimitReached) {
+            return status;
+        }
+    }
+
+    if (xml.error() == QXmlStreamReader::PrematureEndOfDocumentError) {
+        return status;
+    }
+
+    status = xml.hasError() ? Error : Finished;
+    return status;
+}
+
+void FeedParser::startElement(FeedTag tag)
+{
+    field = nullptr;
+
+    if (tag == FeedTag::ItemBoundary || tag == FeedTag::ItemOpen) {
+        inItem = true;
+        newsItem = NewsItem();
+        forecastItem = ForecastItem();
+        return;
+    }
+
+    if (isItemField(tag) && !(fields & feedField(tag))) {
+        skipDepth = 1;
+        return;
+    }
+
+    if (!inItem) {
+        // Channel level refresh hint
+        if (tag == FeedTag::Ttl) {
+            field = &ttl;
+            field->clear();
+        }
+        return;
+    }
+
+    switch (tag) {
+    case FeedTag::Title: field = &newsItem.title; break;
+    case FeedTag::Link: {
+        // Atom links carry the URL in href; only the alternate one is the article
+        const QXmlStreamAttributes attributes = xml.attributes();
+        if (attributes.hasAttribute(QLatin1String("href"))) {
+            const QStringRef rel = attributes.value(QLatin1String("rel"));
+            if (rel.isEmpty() || rel == QLatin1String("alternate")) {
+                newsItem.link = attributes.value(QLatin1String("href")).toString();
+            }
+        } else {
+            field = &newsItem.link;
+        }
+        break;
+    }
+    case FeedTag::Description: field = &newsItem.description; break;
+    case FeedTag::PubDate: field = &newsItem.pubDate; break;
+    case FeedTag::Guid: field = &newsItem.guid; break;
+    case FeedTag::MaxTemp: field = &forecastItem.maxTemp; break;
+    case FeedTag::MinTemp: field = &forecastItem.minTemp; break;
+    case FeedTag::Date: field = &forecastItem.date; break;
+    case FeedTag::RainChance: field = &forecastItem.rainChance; break;
+    case FeedTag::Icon: field = &forecastItem.icon; break;
+    case FeedTag::Temperature:
+        if (weather) weather->temperature = attributeValue();
+        break;
+    case FeedTag::FeelsLike:
+        if (weather) weather->feelsLike = attributeValue();
+        break;
+    case FeedTag::Weather:
+        if (weather) weather->weather = attributeValue();
+        break;
+    default:
+        break;
+    }
+
+    if (field) {
+        field->clear();
+    }
+}
+
+void FeedParser::endElement(FeedTag tag)
+{
+    field = nullptr;
+
+    if (!inItem || (tag != FeedTag::ItemBoundary && tag != FeedTag::ItemClose)) {
+        return;
+    }
+
+    inItem = false;
+    if (news) {
+        news->items.push_back(std::move(newsItem));
+        newsItem = NewsItem();
+        checkLimit(int(news->items.size()));
+    } else if (forecast) {
+        insertForecastDay(forecastItem);
+        checkLimit(forecast->count);
+    }
+}
+
+QString FeedParser::attributeValue() const
+{
+    return xml.attributes().value(QLatin1String("value")).toString();
+}
+
+void FeedParser::insertForecastDay(const ForecastItem &day)
+{
+    // Insertion into the fixed array keeps it sorted; later days fall off
+    int position = forecast->count;
+    while (position > 0 && day.date < forecast->days[position - 1].date) {
+        position--;
+    }
+    if (position >= Forecast::MAX_DAYS) {
+        return;
+    }
+
+    const int last = qMin(forecast->count, Forecast::MAX_DAYS - 1);
+    for (int i = last; i > position; --i) {
+        forecast->days[i] = std::move(forecast->days[i - 1]);
+    }
+    forecast->days[position] = day;
+    forecast->count = qMin(forecast->count + 1, Forecast::MAX_DAYS);
+}
+
+void FeedParser::checkLimit(int count)
+{
+    if (itemLimit > 0 && count >= itemLimit) {
+        status = LimitReached;
+    }
+}
@@ -0,0 +1,162 @@
+#ifndef FEEDPARSER_H
+#define FEEDPARSER_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QXmlStreamReader>
+#include <array>
+#include <memory>
+#include <vector>
+
+// Structures to hold XML data
+struct NewsItem {
+    QString title;
+    QString link;
+    QString description;
+    QString pubDate;
+    QString guid;
+};
+
+struct ForecastItem {
+    QString date;
+    QString maxTemp;
+    QString minTemp;
+    QString rainChance;
+    QString icon;
+};
+
+// Headlines in document order, from RSS items or Atom entries
+struct NewsFeed {
+    std::vector<NewsItem> items;
+};
+
+// Current conditions; fields missing from the document stay empty
+struct CurrentWeather {
+    QString temperature;
+    QString feelsLike;
+    QString weather;
+};
+
+// The earliest days of a forecast, sorted by date
+struct Forecast {
+    static constexpr int MAX_DAYS = 3;
+    std::array<ForecastItem, MAX_DAYS> days;
+    int count = 0;
+};
+
+// Outcome of parsing one document. Only the member matching the feed type is
+// set. Results are immutable once parsed, so readers, the UI and the state
+// snapshot share them instead of copying.
+struct FeedResult {
+    std::shared_ptr<const NewsFeed> news;
+    std::shared_ptr<const CurrentWeather> weather;
+    std::shared_ptr<const Forecast> forecast;
+
+    int itemCount() const;
+};
+
+enum XmlType {
+    NEWS,
+    WEATHER,
+    FORECAST
+};
+
+// Elements the parser reacts to; everything else is ignored
+enum class FeedTag {
+    None,
+    ItemBoundary,
+    ItemOpen,
+    ItemClose,
+    Title,
+    Link,
+    Description,
+    PubDate,
+    Guid,
+    Ttl,
+    Temperature,
+    FeelsLike,
+    Weather,
+    MaxTemp,
+    MinTemp,
+    Date,
+    RainChance,
+    Icon
+};
+
+// Projection of the fields a consumer reads, one bit per FeedTag. Elements of
+// fields outside the projection are skipped without decoding their text.
+using FeedFields = quint32;
+
+constexpr FeedFields feedField(FeedTag tag)
+{
+    return FeedFields(1) << int(tag);
+}
+
+static constexpr FeedFields ALL_FEED_FIELDS = ~FeedFields(0);
+
+// What the dashboard reads from news feeds: headlines are shown, dates and
+// GUIDs order and deduplicate the sources
+static constexpr FeedFields NEWS_FIELDS =
+    feedField(FeedTag::Title) | feedField(FeedTag::PubDate) | feedField(FeedTag::Guid);
+
+// Incremental feed parser that can be fed a document chunk by chunk
+class FeedParser
+{
+public:
+    enum Status {
+        NeedMoreData,
+        Finished,
+        LimitReached,
+        Error
+    };
+
+    // A non-positive item limit parses the whole document
+    explicit FeedParser(XmlType type = XmlType::NEWS, int itemLimit = 0, FeedFields fields = ALL_FEED_FIELDS);
+
+    // Discards all state and prepares for a new document
+    void reset(XmlType newType, int newItemLimit = 0, FeedFields newFields = ALL_FEED_FIELDS);
+
+    // Parses as far as the data received so far allows
+    Status addData(const QByteArray &chunk);
+
+    // Marks the end of input; a document still incomplete is an error
+    Status finish();
+
+    // Hands the parsed result over; the parser starts a fresh one on reset()
+    FeedResult takeResult();
+
+    QString errorString() const;
+
+    // RSS <ttl> of the channel in minutes, 0 if the feed has none
+    int ttlMinutes() const;
+
+private:
+    QXmlStreamReader xml;
+    XmlType type;
+    int itemLimit;
+    FeedFields fields;
+    Status status = NeedMoreData;
+    std::shared_ptr<NewsFeed> news;
+    std::shared_ptr<CurrentWeather> weather;
+    std::shared_ptr<Forecast> forecast;
+    bool inItem = false;
+    NewsItem newsItem;
+    ForecastItem forecastItem;
+    QString ttl;
+
+    // Field collecting character data of the current element, if any
+    QString *field = nullptr;
+
+    // Depth inside an element being skipped, 0 when not skipping
+    int skipDepth = 0;
+
+    Status parse();
+    void startElement(FeedTag tag);
+    void endElement(FeedTag tag);
+    QString attributeValue() const;
+    void insertForecastDay(const ForecastItem &day);
+    void checkLimit(int count);
+};
+
+#endif // FEEDPARSER_H
@@ -0,0 +1,32 @@
+#include "FeedProtocol.h"
+#include <QtEndian>
+
+namespace FeedProtocol {
+QByteArray frame(const QByteArray &body)
+{
+    QByteArray message(sizeof(quint32), Qt::Uninitialized);
+    qToBigEndian(quint32(body.size()), message.data());
+    return message + body;
+}
+
+bool takeMessage(QByteArray *buffer, QByteArray *body, bool *malformed)
+{
+    *malformed = false;
+    if (buffer->size() < int(sizeof(quint32))) {
+        return false;
+    }
+
+    const quint32 length = qFromBigEndian<quint32>(buffer->constData());
+    if (length > quint32(MAX_MESSAGE_BYTES)) {
+        *malformed = true;
+        return false;
+    }
+    if (buffer->size() < int(sizeof(quint32) + length)) {
+        return false;
+    }
+
+    *body = buffer->mid(sizeof(quint32), int(length));
+    buffer->remove(0, int(sizeof(quint32) + length));
+    return true;
+}
+}
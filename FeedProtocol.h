@@ -0,0 +1,50 @@
+#ifndef FEEDPROTOCOL_H
+#define FEEDPROTOCOL_H
+
+#include <QByteArray>
+#include "FeedParser.h"
+
+// Messages between the feed daemon and subscribed dashboards. Each one is a
+// quint32 length followed by a QDataStream (Qt 5.15) body:
+//   Hello   (subscriber): magic, version, HELLO, epoch, count, count x (part, partVersion)
+//   Sources (daemon):     magic, version, SOURCES, news source count
+//   Update  (daemon):     magic, version, UPDATE, epoch, part, partVersion, encoded result
+// The daemon answers a hello with its number of news sources, so the
+// subscriber knows when it has heard from all of them, then sends the parts.
+// A part is one feed result, identified by its type and source. Its version
+// only changes when the parsed content does. A subscriber is sent only the
+// parts it does not already hold, each one whole: unchanged parts are
+// suppressed, but a changed one is not diffed.
+namespace FeedProtocol {
+static const quint32 MAGIC = 0x50444650; // "PDFP"
+static const quint32 VERSION = 2;
+static const quint8 HELLO = 1;
+static const quint8 UPDATE = 2;
+static const quint8 SOURCES = 3;
+static const int MAX_MESSAGE_BYTES = 1024 * 1024;
+static const char DEFAULT_SOCKET[] = "pidashboard-feeds";
+
+inline quint32 partKey(XmlType type, int source)
+{
+    return (quint32(type) << 16) | quint32(source & 0xffff);
+}
+
+inline XmlType partType(quint32 key)
+{
+    return XmlType(key >> 16);
+}
+
+inline int partSource(quint32 key)
+{
+    return int(key & 0xffff);
+}
+
+// Prefixes a message body with its length
+QByteArray frame(const QByteArray &body);
+
+// Removes the first complete message from buffer into body. Returns false
+// while it is incomplete, or with malformed set if it cannot be valid.
+bool takeMessage(QByteArray *buffer, QByteArray *body, bool *malformed);
+}
+
+#endif // FEEDPROTOCOL_H
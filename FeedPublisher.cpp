@@ -0,0 +1,201 @@
+#include "FeedPublisher.h"
+#include "FeedProtocol.h"
+#include "StateSnapshot.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QLocalSocket>
+#include <QTcpSocket>
+
+namespace {
+// A subscriber this far behind is dropped; it catches up on reconnect
+static const qint64 MAX_PENDING_BYTES = 4 * 1024 * 1024;
+// More parts than any configuration has feeds
+static const quint32 MAX_HELLO_PARTS = 1024;
+}
+
+FeedPublisher::FeedPublisher(QObject *parent)
+    : QObject(parent),
+    epoch(quint64(QDateTime::currentMSecsSinceEpoch()))
+{
+    connect(&localServer, &QLocalServer::newConnection, this, &FeedPublisher::onLocalConnection);
+    connect(&tcpServer, &QTcpServer::newConnection, this, &FeedPublisher::onTcpConnection);
+}
+
+bool FeedPublisher::listenLocal(const QString &name)
+{
+    // A socket file left behind by a crashed daemon would block the name
+    QLocalServer::removeServer(name);
+    if (!localServer.listen(name)) {
+        qInfo() << "Feed socket unavailable:" << localServer.errorString();
+        return false;
+    }
+    qInfo() << "Publishing feeds on" << localServer.fullServerName();
+    return true;
+}
+
+bool FeedPublisher::listenTcp(quint16 port)
+{
+    if (port == 0) {
+        return false;
+    }
+
+    if (!tcpServer.listen(QHostAddress::Any, port)) {
+        qInfo() << "Feed port unavailable:" << tcpServer.errorString();
+        return false;
+    }
+    qInfo() << "Publishing feeds on port" << port;
+    return true;
+}
+
+int FeedPublisher::subscriberCount() const
+{
+    return subscribers.size();
+}
+
+void FeedPublisher::setNewsSourceCount(int count)
+{
+    newsSourceCount = count;
+}
+
+void FeedPublisher::publish(XmlType type, int source, const FeedResult &result)
+{
+    QByteArray encoded;
+    QDataStream out(&encoded, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_15);
+    StateSnapshot::writeResult(out, result);
+
+    // Refetched but identical content is not a change
+    const quint32 key = FeedProtocol::partKey(type, source);
+    Part &part = parts[key];
+    if (part.version != 0 && part.encoded == encoded) {
+        return;
+    }
+    part.version = nextVersion++;
+    part.encoded = encoded;
+
+    const QList<QIODevice *> sockets = subscribers.keys();
+    for (QIODevice *socket : sockets) {
+        if (subscribers.value(socket).subscribed) {
+            send(socket, key, part);
+        }
+    }
+}
+
+void FeedPublisher::onLocalConnection()
+{
+    while (QLocalSocket *socket = localServer.nextPendingConnection()) {
+        connect(socket, &QLocalSocket::disconnected, this, [this, socket]() { drop(socket); });
+        addSubscriber(socket);
+    }
+}
+
+void FeedPublisher::onTcpConnection()
+{
+    while (QTcpSocket *socket = tcpServer.nextPendingConnection()) {
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() { drop(socket); });
+        addSubscriber(socket);
+    }
+}
+
+void FeedPublisher::addSubscriber(QIODevice *socket)
+{
+    subscribers.insert(socket, Subscriber());
+    connect(socket, &QIODevice::readyRead, this, [this, socket]() { onReadyRead(socket); });
+}
+
+void FeedPublisher::onReadyRead(QIODevice *socket)
+{
+    auto subscriber = subscribers.find(socket);
+    if (subscriber == subscribers.end()) {
+        return;
+    }
+
+    // Only the hello is expected; anything after it is ignored
+    const QByteArray data = socket->readAll();
+    if (subscriber->subscribed) {
+        return;
+    }
+    subscriber->buffer += data;
+
+    QByteArray body;
+    bool malformed = false;
+    if (!FeedProtocol::takeMessage(&subscriber->buffer, &body, &malformed)) {
+        if (malformed) {
+            drop(socket);
+        }
+        return;
+    }
+
+    QDataStream in(body);
+    in.setVersion(QDataStream::Qt_5_15);
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint8 message = 0;
+    quint64 knownEpoch = 0;
+    quint32 count = 0;
+    in >> magic >> version >> message >> knownEpoch >> count;
+    if (in.status() != QDataStream::Ok || magic != FeedProtocol::MAGIC || version != FeedProtocol::VERSION
+        || message != FeedProtocol::HELLO || count > MAX_HELLO_PARTS) {
+        qInfo() << "Rejected feed subscriber with an invalid hello";
+        drop(socket);
+        return;
+    }
+
+    // Versions from another daemon run mean nothing here
+    QHash<quint32, quint64> known;
+    for (quint32 i = 0; i < count; ++i) {
+        quint32 key = 0;
+        quint64 partVersion = 0;
+        in >> key >> partVersion;
+        if (knownEpoch == epoch) {
+            known.insert(key, partVersion);
+        }
+    }
+    if (in.status() != QDataStream::Ok) {
+        drop(socket);
+        return;
+    }
+
+    subscriber->subscribed = true;
+    subscriber->buffer.clear();
+    qInfo() << "Feed subscriber connected," << subscribers.size() << "in total";
+
+    QByteArray sources;
+    QDataStream out(&sources, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << FeedProtocol::MAGIC << FeedProtocol::VERSION << FeedProtocol::SOURCES << quint32(newsSourceCount);
+    socket->write(FeedProtocol::frame(sources));
+
+    for (auto part = parts.cbegin(); part != parts.cend(); ++part) {
+        if (known.value(part.key()) != part->version) {
+            send(socket, part.key(), *part);
+        }
+    }
+}
+
+void FeedPublisher::send(QIODevice *socket, quint32 key, const Part &part)
+{
+    if (socket->bytesToWrite() > MAX_PENDING_BYTES) {
+        qInfo() << "Dropping a feed subscriber that stopped reading";
+        drop(socket);
+        return;
+    }
+
+    QByteArray body;
+    QDataStream out(&body, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << FeedProtocol::MAGIC << FeedProtocol::VERSION << FeedProtocol::UPDATE << epoch
+        << key << part.version << part.encoded;
+    socket->write(FeedProtocol::frame(body));
+}
+
+void FeedPublisher::drop(QIODevice *socket)
+{
+    if (!subscribers.remove(socket)) {
+        return;
+    }
+    socket->disconnect(this);
+    socket->close();
+    socket->deleteLater();
+}
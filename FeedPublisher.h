@@ -0,0 +1,66 @@
+#ifndef FEEDPUBLISHER_H
+#define FEEDPUBLISHER_H
+
+#include <QObject>
+#include <QHash>
+#include <QLocalServer>
+#include <QMap>
+#include <QTcpServer>
+#include "FeedParser.h"
+
+// Daemon side of the feed protocol. Keeps the latest result of every feed as
+// a versioned part and pushes each changed part to all subscribed dashboards,
+// over a local socket on this host and optionally TCP for other hosts.
+class FeedPublisher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FeedPublisher(QObject *parent = nullptr);
+
+    // Listens on a local socket, given as a name or an absolute path
+    bool listenLocal(const QString &name);
+
+    // Listens on all interfaces; a port of 0 disables TCP
+    bool listenTcp(quint16 port);
+
+    int subscriberCount() const;
+
+    // Announced to every subscriber before the parts
+    void setNewsSourceCount(int count);
+
+public slots:
+    // Sends the result to every subscriber unless it is unchanged
+    void publish(XmlType type, int source, const FeedResult &result);
+
+private slots:
+    void onLocalConnection();
+    void onTcpConnection();
+
+private:
+    struct Part {
+        quint64 version = 0;
+        QByteArray encoded;
+    };
+
+    struct Subscriber {
+        QByteArray buffer;
+        bool subscribed = false;
+    };
+
+    QLocalServer localServer;
+    QTcpServer tcpServer;
+    // Distinguishes versions from those of a previous daemon run
+    const quint64 epoch;
+    quint64 nextVersion = 1;
+    int newsSourceCount = 1;
+    QMap<quint32, Part> parts;
+    QHash<QIODevice *, Subscriber> subscribers;
+
+    void addSubscriber(QIODevice *socket);
+    void onReadyRead(QIODevice *socket);
+    void send(QIODevice *socket, quint32 key, const Part &part);
+    void drop(QIODevice *socket);
+};
+
+#endif // FEEDPUBLISHER_H
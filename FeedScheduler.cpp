@@ -0,0 +1,186 @@
+#include "FeedScheduler.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRandomGenerator>
+#include <QSaveFile>
+
+namespace {
+static const qint64 DEFAULT_INTERVAL_MS = 10 * 60 * 1000;
+static const qint64 MIN_INTERVAL_MS = 5 * 60 * 1000;
+static const qint64 MAX_INTERVAL_MS = 6 * 60 * 60 * 1000;
+static const qint64 BACKOFF_BASE_MS = 30 * 1000;
+static const qint64 BACKOFF_MAX_MS = 60 * 60 * 1000;
+static const double BACKOFF_JITTER = 0.2;
+static const qint64 DAY_MS = 24 * 60 * 60 * 1000;
+static const quint32 STATE_MAGIC = 0x50444253; // "PDBS"
+static const quint32 STATE_VERSION = 1;
+}
+
+FeedScheduler::FeedScheduler(QObject *parent)
+    : QObject(parent)
+{
+}
+
+int FeedScheduler::addFeed(const QString &name, const QString &provider, std::function<void()> fetch)
+{
+    const int id = feeds.size();
+
+    QTimer *timer = new QTimer(this);
+    timer->setSingleShot(true);
+    // Second precision is plenty and lets the OS coalesce wake-ups
+    timer->setTimerType(Qt::VeryCoarseTimer);
+    connect(timer, &QTimer::timeout, this, [this, id]() {
+        fire(id);
+    });
+
+    feeds.append({name, provider, std::move(fetch), timer});
+    return id;
+}
+
+void FeedScheduler::setProviderBudget(const QString &provider, int requestsPerDay)
+{
+    budgets[provider].requestsPerDay = requestsPerDay;
+}
+
+void FeedScheduler::setStateFile(const QString &path)
+{
+    stateFile = path;
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_15);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QHash<QString, QList<qint64>> sent;
+    in >> magic >> version >> sent;
+    if (in.status() != QDataStream::Ok || magic != STATE_MAGIC || version != STATE_VERSION) {
+        return;
+    }
+
+    // Requests older than a day no longer count
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (auto it = sent.cbegin(); it != sent.cend(); ++it) {
+        QQueue<qint64> &queue = budgets[it.key()].sent;
+        queue.clear();
+        for (qint64 time : it.value()) {
+            if (time > now - DAY_MS) {
+                queue.enqueue(time);
+            }
+        }
+    }
+}
+
+void FeedScheduler::start()
+{
+    for (int id = 0; id < feeds.size(); ++id) {
+        fire(id);
+    }
+}
+
+void FeedScheduler::setMinimumInterval(qint64 intervalMs)
+{
+    minimumIntervalMs = intervalMs;
+
+    // Postpone fetches already due sooner; retries after errors keep their pace
+    for (int id = 0; id < feeds.size(); ++id) {
+        const Feed &entry = feeds[id];
+        if (intervalMs > 0 && entry.failures == 0 && entry.timer->isActive()
+            && entry.timer->remainingTime() < intervalMs) {
+            schedule(id, intervalMs);
+        }
+    }
+}
+
+quint64 FeedScheduler::deferredFetches() const
+{
+    return deferred;
+}
+
+void FeedScheduler::reportSuccess(int feed, int freshnessSeconds)
+{
+    feeds[feed].failures = 0;
+
+    qint64 delay = freshnessSeconds < 0 ? DEFAULT_INTERVAL_MS : freshnessSeconds * 1000LL;
+    delay = qBound(MIN_INTERVAL_MS, delay, MAX_INTERVAL_MS);
+    if (delay < minimumIntervalMs) {
+        deferred += quint64(minimumIntervalMs / delay - 1);
+        delay = minimumIntervalMs;
+    }
+    schedule(feed, delay);
+}
+
+void FeedScheduler::reportError(int feed)
+{
+    Feed &entry = feeds[feed];
+    entry.failures++;
+
+    // Exponential backoff with jitter so several screens do not retry in step
+    qint64 delay = qMin(BACKOFF_MAX_MS, BACKOFF_BASE_MS << qMin(entry.failures - 1, 16));
+    double jitter = 1.0 + BACKOFF_JITTER * (2.0 * QRandomGenerator::global()->generateDouble() - 1.0);
+    delay = qint64(delay * jitter);
+
+    qInfo() << "Feed" << entry.name << "failed" << entry.failures << "times, retrying in" << delay / 1000 << "s";
+    schedule(feed, delay);
+}
+
+void FeedScheduler::schedule(int feed, qint64 delayMs)
+{
+    feeds[feed].timer->start(int(delayMs));
+}
+
+void FeedScheduler::fire(int feed)
+{
+    Feed &entry = feeds[feed];
+    // A forced fetch replaces the pending one
+    entry.timer->stop();
+
+    auto it = budgets.find(entry.provider);
+    if (it != budgets.end() && it->requestsPerDay > 0) {
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        while (!it->sent.isEmpty() && it->sent.head() <= now - DAY_MS) {
+            it->sent.dequeue();
+        }
+
+        // Out of budget: wait until the oldest request leaves the window
+        if (it->sent.size() >= it->requestsPerDay) {
+            qint64 wait = it->sent.head() + DAY_MS - now;
+            qInfo() << "Provider" << entry.provider << "budget exhausted, delaying" << entry.name << "by" << wait / 1000 << "s";
+            schedule(feed, wait);
+            return;
+        }
+        it->sent.enqueue(now);
+        saveState();
+    }
+
+    entry.fetch();
+}
+
+void FeedScheduler::saveState() const
+{
+    if (stateFile.isEmpty()) {
+        return;
+    }
+
+    QHash<QString, QList<qint64>> sent;
+    for (auto it = budgets.cbegin(); it != budgets.cend(); ++it) {
+        sent.insert(it.key(), it->sent);
+    }
+
+    QDir().mkpath(QFileInfo(stateFile).absolutePath());
+    QSaveFile file(stateFile);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qInfo() << "Cannot save request budgets:" << file.errorString();
+        return;
+    }
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << STATE_MAGIC << STATE_VERSION << sent;
+    file.commit();
+}
@@ -0,0 +1,72 @@
+#ifndef FEEDSCHEDULER_H
+#define FEEDSCHEDULER_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QQueue>
+#include <QTimer>
+#include <functional>
+
+// Schedules each feed on its own interval. After a success the next fetch
+// follows the freshness the source advertised (Cache-Control, Expires or
+// RSS <ttl>); after an error it backs off exponentially with jitter. Each
+// provider can have a daily request budget that is never exceeded; with a
+// state file the requests sent are kept across restarts as well.
+class FeedScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FeedScheduler(QObject *parent = nullptr);
+
+    // Registers a feed and returns its id; fetch is called whenever it is due
+    int addFeed(const QString &name, const QString &provider, std::function<void()> fetch);
+
+    // Limits the requests sent to a provider within any 24 hours
+    void setProviderBudget(const QString &provider, int requestsPerDay);
+
+    // Loads the requests sent within the last 24 hours from the file and
+    // records every further one there
+    void setStateFile(const QString &path);
+
+    // Fetches every registered feed once, right away
+    void start();
+
+    // Stretches the interval after each success to at least intervalMs,
+    // e.g. overnight; 0 restores the advertised freshness
+    void setMinimumInterval(qint64 intervalMs);
+
+    // Fetches skipped so far because of the minimum interval
+    quint64 deferredFetches() const;
+
+    // Reports a fetch outcome; freshnessSeconds < 0 means no hint was given
+    void reportSuccess(int feed, int freshnessSeconds);
+    void reportError(int feed);
+
+private:
+    struct Feed {
+        QString name;
+        QString provider;
+        std::function<void()> fetch;
+        QTimer *timer;
+        int failures = 0;
+    };
+
+    struct Budget {
+        int requestsPerDay = 0;
+        QQueue<qint64> sent;
+    };
+
+    QList<Feed> feeds;
+    QHash<QString, Budget> budgets;
+    QString stateFile;
+    qint64 minimumIntervalMs = 0;
+    quint64 deferred = 0;
+
+    void schedule(int feed, qint64 delayMs);
+    void fire(int feed);
+    void saveState() const;
+};
+
+#endif // FEEDSCHEDULER_H
@@ -0,0 +1,162 @@
+#include "FeedSubscriber.h"
+#include "FeedProtocol.h"
+#include "StateSnapshot.h"
+#include <QDataStream>
+#include <QDebug>
+
+namespace {
+static const int RECONNECT_DELAY_MS = 5000;
+// Bounds the items decoded from one update
+static const qint64 MAX_UPDATE_ITEMS = 1024;
+}
+
+FeedSubscriber::FeedSubscriber(const QString &server, QObject *parent)
+    : QObject(parent),
+    localSocket(this),
+    tcpSocket(this)
+{
+    // Local socket paths may contain ':' but never start a valid host:port
+    const int colon = server.lastIndexOf(':');
+    bool ok = false;
+    const quint16 tcpPort = colon > 0 ? server.mid(colon + 1).toUShort(&ok) : 0;
+    if (ok && !server.startsWith('/')) {
+        host = server.left(colon);
+        port = tcpPort;
+        socket = &tcpSocket;
+        connect(&tcpSocket, &QTcpSocket::connected, this, &FeedSubscriber::onConnected);
+        connect(&tcpSocket, &QTcpSocket::disconnected, this, &FeedSubscriber::onConnectionLost);
+        connect(&tcpSocket, &QTcpSocket::errorOccurred, this, &FeedSubscriber::onConnectionLost);
+    } else {
+        localName = server;
+        socket = &localSocket;
+        connect(&localSocket, &QLocalSocket::connected, this, &FeedSubscriber::onConnected);
+        connect(&localSocket, &QLocalSocket::disconnected, this, &FeedSubscriber::onConnectionLost);
+        connect(&localSocket, &QLocalSocket::errorOccurred, this, &FeedSubscriber::onConnectionLost);
+    }
+    connect(socket, &QIODevice::readyRead, this, &FeedSubscriber::onReadyRead);
+
+    reconnectTimer.setSingleShot(true);
+    reconnectTimer.setInterval(RECONNECT_DELAY_MS);
+    connect(&reconnectTimer, &QTimer::timeout, this, &FeedSubscriber::connectToServer);
+}
+
+void FeedSubscriber::start()
+{
+    connectToServer();
+}
+
+void FeedSubscriber::connectToServer()
+{
+    // Aborting a live connection reports it lost; this is the retry
+    if (socket == &tcpSocket) {
+        tcpSocket.abort();
+    } else {
+        localSocket.abort();
+    }
+    reconnectTimer.stop();
+    buffer.clear();
+
+    if (socket == &tcpSocket) {
+        tcpSocket.connectToHost(host, port);
+    } else {
+        localSocket.connectToServer(localName);
+    }
+}
+
+void FeedSubscriber::onConnected()
+{
+    // Announce what is already shown so only newer parts are sent
+    QByteArray body;
+    QDataStream out(&body, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << FeedProtocol::MAGIC << FeedProtocol::VERSION << FeedProtocol::HELLO << epoch << quint32(versions.size());
+    for (auto it = versions.cbegin(); it != versions.cend(); ++it) {
+        out << it.key() << it.value();
+    }
+    socket->write(FeedProtocol::frame(body));
+    qInfo() << "Subscribed to the feed daemon";
+}
+
+void FeedSubscriber::onReadyRead()
+{
+    buffer += socket->readAll();
+
+    QByteArray body;
+    bool malformed = false;
+    while (FeedProtocol::takeMessage(&buffer, &body, &malformed)) {
+        if (!handleMessage(body)) {
+            malformed = true;
+            break;
+        }
+    }
+    if (malformed) {
+        qInfo() << "Invalid message from the feed daemon";
+        onConnectionLost();
+    }
+}
+
+void FeedSubscriber::onConnectionLost()
+{
+    // The last received data stays on screen until the daemon is back
+    if (!reconnectTimer.isActive()) {
+        qInfo() << "Feed daemon unavailable, retrying in" << RECONNECT_DELAY_MS / 1000 << "s";
+        reconnectTimer.start();
+    }
+}
+
+bool FeedSubscriber::handleMessage(const QByteArray &body)
+{
+    QDataStream in(body);
+    in.setVersion(QDataStream::Qt_5_15);
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint8 message = 0;
+    in >> magic >> version >> message;
+    if (in.status() != QDataStream::Ok || magic != FeedProtocol::MAGIC || version != FeedProtocol::VERSION) {
+        return false;
+    }
+
+    if (message == FeedProtocol::SOURCES) {
+        quint32 count = 0;
+        in >> count;
+        // Sources are numbered in 16 bits of the part key
+        if (in.status() != QDataStream::Ok || count == 0 || count > 0xffff) {
+            return false;
+        }
+        emit newsSourcesAnnounced(int(count));
+        return true;
+    }
+    if (message != FeedProtocol::UPDATE) {
+        return false;
+    }
+
+    quint64 updateEpoch = 0;
+    quint32 key = 0;
+    quint64 partVersion = 0;
+    QByteArray encoded;
+    in >> updateEpoch >> key >> partVersion >> encoded;
+    if (in.status() != QDataStream::Ok) {
+        return false;
+    }
+
+    const XmlType type = FeedProtocol::partType(key);
+    if (type != XmlType::NEWS && type != XmlType::WEATHER && type != XmlType::FORECAST) {
+        return false;
+    }
+
+    QDataStream result(encoded);
+    result.setVersion(QDataStream::Qt_5_15);
+    FeedResult decoded;
+    if (!StateSnapshot::readResult(result, type, MAX_UPDATE_ITEMS, &decoded)) {
+        return false;
+    }
+
+    // A restarted daemon numbers its versions afresh
+    if (updateEpoch != epoch) {
+        epoch = updateEpoch;
+        versions.clear();
+    }
+    versions.insert(key, partVersion);
+    emit resultLoaded(type, FeedProtocol::partSource(key), decoded);
+    return true;
+}
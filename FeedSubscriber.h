@@ -0,0 +1,51 @@
+#ifndef FEEDSUBSCRIBER_H
+#define FEEDSUBSCRIBER_H
+
+#include <QObject>
+#include <QHash>
+#include <QLocalSocket>
+#include <QTcpSocket>
+#include <QTimer>
+#include "FeedParser.h"
+
+// Dashboard side of the feed protocol. Receives the feeds fetched by a
+// daemon instead of fetching them itself, so API request volume does not
+// grow with the number of screens. Reconnects by itself and then only
+// receives the parts that changed meanwhile.
+class FeedSubscriber : public QObject
+{
+    Q_OBJECT
+
+public:
+    // server is host:port for TCP, otherwise a local socket name or path
+    explicit FeedSubscriber(const QString &server, QObject *parent = nullptr);
+
+    void start();
+
+signals:
+    // Same meaning as FeedFetcher::resultLoaded
+    void resultLoaded(XmlType type, int source, const FeedResult &result);
+
+    // The daemon's number of news sources, sent before any result
+    void newsSourcesAnnounced(int count);
+
+private:
+    QString localName;
+    QString host;
+    quint16 port = 0;
+    QLocalSocket localSocket;
+    QTcpSocket tcpSocket;
+    QIODevice *socket;
+    QTimer reconnectTimer;
+    QByteArray buffer;
+    quint64 epoch = 0;
+    QHash<quint32, quint64> versions;
+
+    void connectToServer();
+    void onConnected();
+    void onReadyRead();
+    void onConnectionLost();
+    bool handleMessage(const QByteArray &body);
+};
+
+#endif // FEEDSUBSCRIBER_H
@@ -0,0 +1,153 @@
+#include "FrameBatcher.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include <QEvent>
+#include <QVector>
+
+namespace {
+// Results of one refresh usually arrive within this gap of each other
+static const int QUIET_MS = 150;
+// A slow feed or icon must not hold back the others for long
+static const int DEADLINE_MS = 1500;
+}
+
+FrameBatcher::FrameBatcher(QObject *parent)
+    : QObject(parent)
+{
+    quietTimer.setSingleShot(true);
+    quietTimer.setInterval(QUIET_MS);
+    connect(&quietTimer, &QTimer::timeout, this, &FrameBatcher::commit);
+
+    deadlineTimer.setSingleShot(true);
+    deadlineTimer.setInterval(DEADLINE_MS);
+    connect(&deadlineTimer, &QTimer::timeout, this, &FrameBatcher::commit);
+}
+
+void FrameBatcher::watch(QWidget *newWindow)
+{
+    window = newWindow;
+
+    // The backing store sends UpdateRequest to the window once per repaint
+    // pass; every widget with a layout gets a LayoutRequest per layout pass
+    window->installEventFilter(this);
+    for (QWidget *widget : window->findChildren<QWidget *>()) {
+        if (widget->layout()) {
+            widget->installEventFilter(this);
+        }
+    }
+}
+
+void FrameBatcher::setText(QLabel *label, const QString &text)
+{
+    Change &pendingChange = change(label);
+    pendingChange.hasText = true;
+    pendingChange.text = text;
+}
+
+void FrameBatcher::setPixmap(QLabel *label, const QPixmap &pixmap)
+{
+    Change &pendingChange = change(label);
+    pendingChange.hasPixmap = true;
+    pendingChange.pixmap = pixmap;
+}
+
+void FrameBatcher::setVisible(QWidget *widget, bool visible)
+{
+    change(widget).visible = visible ? 1 : 0;
+}
+
+void FrameBatcher::commit()
+{
+    static Metrics::Counter &commits = Metrics::counter("pidashboard_frame_commits_total",
+                                                        "Batches of label changes applied to the window.");
+    static Metrics::Counter &changes = Metrics::counter("pidashboard_frame_changes_total",
+                                                        "Label changes applied in frame commits.");
+
+    quietTimer.stop();
+    deadlineTimer.stop();
+
+    // Values equal to what is shown are dropped, so an unchanged refresh
+    // causes no layout pass and no repaint at all
+    QVector<Change> effective;
+    effective.reserve(pending.size());
+    for (Change pendingChange : qAsConst(pending)) {
+        QWidget *widget = pendingChange.widget;
+        if (!widget) {
+            continue;
+        }
+        QLabel *label = qobject_cast<QLabel *>(widget);
+        pendingChange.hasText = pendingChange.hasText && label && label->text() != pendingChange.text;
+        pendingChange.hasPixmap = pendingChange.hasPixmap && label
+                                  && label->pixmap(Qt::ReturnByValue).cacheKey() != pendingChange.pixmap.cacheKey();
+        if (pendingChange.visible >= 0 && widget->isVisibleTo(widget->parentWidget()) == bool(pendingChange.visible)) {
+            pendingChange.visible = -1;
+        }
+        if (pendingChange.hasText || pendingChange.hasPixmap || pendingChange.visible >= 0) {
+            effective.append(pendingChange);
+        }
+    }
+    pending.clear();
+    if (effective.isEmpty()) {
+        return;
+    }
+    Trace::Span span("FrameBatcher::commit", "gui");
+
+    // Applied back to back, the widgets' own updates and layout requests are
+    // merged into one layout pass and one repaint of just the changed areas
+    int applied = 0;
+    for (const Change &pendingChange : qAsConst(effective)) {
+        QWidget *widget = pendingChange.widget;
+        QLabel *label = qobject_cast<QLabel *>(widget);
+        if (pendingChange.hasText) {
+            label->setText(pendingChange.text);
+            applied++;
+        }
+        if (pendingChange.hasPixmap) {
+            label->setPixmap(pendingChange.pixmap);
+            applied++;
+        }
+        if (pendingChange.visible >= 0) {
+            widget->setVisible(pendingChange.visible);
+            applied++;
+        }
+    }
+
+    counts.commits++;
+    counts.changes += applied;
+    commits.add();
+    changes.add(applied);
+}
+
+const FrameBatcher::Stats &FrameBatcher::stats() const
+{
+    return counts;
+}
+
+bool FrameBatcher::eventFilter(QObject *watched, QEvent *event)
+{
+    static Metrics::Counter &layoutPasses = Metrics::counter("pidashboard_gui_layout_passes_total",
+                                                             "Layout passes of widgets in the main window.");
+    static Metrics::Counter &repaints = Metrics::counter("pidashboard_gui_repaints_total",
+                                                         "Repaint passes of the main window.");
+
+    if (event->type() == QEvent::LayoutRequest) {
+        counts.layoutPasses++;
+        layoutPasses.add();
+    } else if (event->type() == QEvent::UpdateRequest && watched == window) {
+        counts.repaints++;
+        repaints.add();
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+FrameBatcher::Change &FrameBatcher::change(QWidget *widget)
+{
+    if (!deadlineTimer.isActive()) {
+        deadlineTimer.start();
+    }
+    quietTimer.start();
+
+    Change &pendingChange = pending[widget];
+    pendingChange.widget = widget;
+    return pendingChange;
+}
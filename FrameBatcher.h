@@ -0,0 +1,68 @@
+#ifndef FRAMEBATCHER_H
+#define FRAMEBATCHER_H
+
+#include <QObject>
+#include <QHash>
+#include <QLabel>
+#include <QPixmap>
+#include <QPointer>
+#include <QTimer>
+
+// Collects the label changes of one refresh and applies them to the window
+// in a single pass, so the refresh costs one layout pass and one repaint of
+// the changed labels instead of one per feed and icon, and no partial state
+// is ever shown. Changes to values already shown are dropped. Changes are
+// committed when the refresh completes, after a short quiet period, or at
+// the latest shortly after the first one.
+class FrameBatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Stats {
+        quint64 commits = 0;
+        quint64 changes = 0;
+        quint64 layoutPasses = 0;
+        quint64 repaints = 0;
+    };
+
+    explicit FrameBatcher(QObject *parent = nullptr);
+
+    // Starts counting layout passes and repaints of the window; call once
+    // all of its widgets exist
+    void watch(QWidget *window);
+
+    // Later changes to the same label replace pending ones
+    void setText(QLabel *label, const QString &text);
+    void setPixmap(QLabel *label, const QPixmap &pixmap);
+    void setVisible(QWidget *widget, bool visible);
+
+    // Applies everything pending now
+    void commit();
+
+    const Stats &stats() const;
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    struct Change {
+        QPointer<QWidget> widget;
+        bool hasText = false;
+        QString text;
+        bool hasPixmap = false;
+        QPixmap pixmap;
+        // -1 unchanged, otherwise the new visibility
+        int visible = -1;
+    };
+
+    QPointer<QWidget> window;
+    QHash<QWidget *, Change> pending;
+    QTimer quietTimer;
+    QTimer deadlineTimer;
+    Stats counts;
+
+    Change &change(QWidget *widget);
+};
+
+#endif // FRAMEBATCHER_H
@@ -0,0 +1,50 @@
+#include "GuiBlockMonitor.h"
+#include <QDebug>
+
+namespace {
+static const int HEARTBEAT_INTERVAL_MS = 5;
+static const int WINDOW_LENGTH_MS = 20 * 1000;
+}
+
+GuiBlockMonitor::GuiBlockMonitor(QObject *parent)
+    : QObject(parent)
+{
+    heartbeat.setTimerType(Qt::PreciseTimer);
+    heartbeat.setInterval(HEARTBEAT_INTERVAL_MS);
+    connect(&heartbeat, &QTimer::timeout, this, &GuiBlockMonitor::onHeartbeat);
+
+    // The heartbeat only runs inside a window so an idle dashboard stays idle
+    window.setSingleShot(true);
+    window.setInterval(WINDOW_LENGTH_MS);
+    connect(&window, &QTimer::timeout, this, &GuiBlockMonitor::onWindowFinished);
+}
+
+void GuiBlockMonitor::startWindow()
+{
+    if (!window.isActive()) {
+        worstNs = 0;
+    }
+    sinceLastTick.start();
+    heartbeat.start();
+    window.start();
+}
+
+double GuiBlockMonitor::worstBlockMs() const
+{
+    return lastWorstMs;
+}
+
+void GuiBlockMonitor::onHeartbeat()
+{
+    qint64 lateNs = sinceLastTick.nsecsElapsed() - HEARTBEAT_INTERVAL_MS * 1000000LL;
+    worstNs = qMax(worstNs, lateNs);
+    sinceLastTick.start();
+}
+
+void GuiBlockMonitor::onWindowFinished()
+{
+    heartbeat.stop();
+    lastWorstMs = worstNs / 1e6;
+    qInfo() << "Worst GUI thread block during refresh:" << lastWorstMs << "ms";
+    emit windowFinished(lastWorstMs);
+}
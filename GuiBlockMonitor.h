@@ -0,0 +1,39 @@
+#ifndef GUIBLOCKMONITOR_H
+#define GUIBLOCKMONITOR_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QTimer>
+
+// Measures how long the GUI event loop is blocked during a refresh. While a
+// measurement window is open a short precise timer runs on the GUI thread
+// and any lateness of its ticks is time the event loop could not run.
+class GuiBlockMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit GuiBlockMonitor(QObject *parent = nullptr);
+
+    // Opens a measurement window, e.g. at the start of a refresh
+    void startWindow();
+
+    // Worst block seen in the last completed window, in milliseconds
+    double worstBlockMs() const;
+
+signals:
+    // Emitted when a measurement window closes
+    void windowFinished(double worstBlockMs);
+
+private:
+    QTimer heartbeat;
+    QTimer window;
+    QElapsedTimer sinceLastTick;
+    qint64 worstNs = 0;
+    double lastWorstMs = 0;
+
+    void onHeartbeat();
+    void onWindowFinished();
+};
+
+#endif // GUIBLOCKMONITOR_H
@@ -0,0 +1,216 @@
+#include "IconCache.h"
+#include "NetworkService.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QNetworkRequest>
+#include <QUrl>
+#include <QRunnable>
+#include <QThreadPool>
+#include <cstring>
+
+namespace {
+static const int MEMORY_MAX_ICONS = 64;
+static const quint32 ICON_MAGIC = 0x50444943; // "PDIC"
+static const quint32 ICON_VERSION = 1;
+
+Metrics::Histogram &downloadDuration()
+{
+    static Metrics::Histogram &histogram = Metrics::histogram(
+        "pidashboard_icon_download_duration_seconds", "Time to download an icon.");
+    return histogram;
+}
+
+Metrics::Histogram &decodeDuration()
+{
+    static Metrics::Histogram &histogram = Metrics::histogram(
+        "pidashboard_icon_decode_duration_seconds", "Time to decode, scale and store an icon.");
+    return histogram;
+}
+}
+
+IconCache *IconCache::instance()
+{
+    static IconCache *cache = new IconCache(QCoreApplication::instance());
+    return cache;
+}
+
+IconCache::IconCache(QObject *parent)
+    : QObject(parent),
+    memory(MEMORY_MAX_ICONS)
+{
+    dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/icons";
+    QDir().mkpath(dir);
+}
+
+bool IconCache::lookup(const QString &url, const QSize &size, QPixmap *pixmap)
+{
+    const QString key = keyFor(url, size);
+
+    if (QPixmap *cached = memory.object(key)) {
+        *pixmap = *cached;
+        return true;
+    }
+
+    QImage image = loadFromDisk(key);
+    if (!image.isNull()) {
+        *pixmap = QPixmap::fromImage(image);
+        memory.insert(key, new QPixmap(*pixmap));
+        return true;
+    }
+
+    // Coalesce identical icons into one in-flight request
+    auto it = inFlight.find(url);
+    if (it != inFlight.end()) {
+        if (!it->contains(size)) {
+            it->append(size);
+        }
+        return false;
+    }
+
+    inFlight.insert(url, {size});
+    QNetworkRequest request{QUrl(url)};
+    request.setAttribute(QNetworkRequest::User, url);
+    NetworkService::instance()->get(request, this, [this](QNetworkReply *reply) {
+        QElapsedTimer timer;
+        timer.start();
+        connect(reply, &QNetworkReply::finished, this, [this, reply, timer]() {
+            downloadDuration().observeNs(timer.nsecsElapsed());
+            onDownloadFinished(reply);
+        });
+    });
+    return false;
+}
+
+void IconCache::insert(const QString &url, const QSize &size, const QImage &image)
+{
+    if (!image.isNull()) {
+        memory.insert(keyFor(url, size), new QPixmap(QPixmap::fromImage(image)));
+    }
+}
+
+void IconCache::onDownloadFinished(QNetworkReply *reply)
+{
+    const QString url = reply->request().attribute(QNetworkRequest::User).toString();
+    const QList<QSize> sizes = inFlight.take(url);
+    const QByteArray data = reply->error() == QNetworkReply::NoError ? reply->readAll() : QByteArray();
+    const QString error = reply->error() == QNetworkReply::NoError ? QString("empty response") : reply->errorString();
+    reply->deleteLater();
+
+    if (data.isEmpty()) {
+        onIconFailed(url, sizes, error);
+        return;
+    }
+
+    // Decode, scale and persist on a worker; QImage is safe off the GUI thread
+    QThreadPool::globalInstance()->start(QRunnable::create([this, url, sizes, data]() {
+        Metrics::ScopedTimer timer(decodeDuration());
+        const QByteArray detail = QUrl(url).fileName().toUtf8();
+        QImage source;
+        {
+            Trace::Span span("decode", "icon", detail.constData());
+            source.loadFromData(data);
+        }
+        if (source.isNull()) {
+            QMetaObject::invokeMethod(this, [this, url, sizes]() {
+                onIconFailed(url, sizes, "cannot decode image");
+            }, Qt::QueuedConnection);
+            return;
+        }
+
+        for (const QSize &size : sizes) {
+            Trace::Span span("scale and store", "icon", detail.constData());
+            QImage image = source.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation)
+                               .convertToFormat(QImage::Format_ARGB32_Premultiplied);
+            storeOnDisk(keyFor(url, size), image);
+
+            QMetaObject::invokeMethod(this, [this, url, size, image]() {
+                onIconDecoded(url, size, image);
+            }, Qt::QueuedConnection);
+        }
+    }));
+}
+
+void IconCache::onIconDecoded(const QString &url, const QSize &size, const QImage &image)
+{
+    Trace::Span span("upload pixmap", "icon");
+    QPixmap pixmap = QPixmap::fromImage(image);
+    memory.insert(keyFor(url, size), new QPixmap(pixmap));
+    emit iconReady(url, size, pixmap);
+}
+
+void IconCache::onIconFailed(const QString &url, const QList<QSize> &sizes, const QString &reason)
+{
+    static Metrics::Counter &failures = Metrics::counter("pidashboard_icon_failures_total",
+                                                         "Icons that could not be downloaded or decoded.");
+    failures.add();
+    qInfo() << "Icon unavailable:" << url << reason;
+    for (const QSize &size : sizes) {
+        emit iconFailed(url, size);
+    }
+}
+
+QString IconCache::keyFor(const QString &url, const QSize &size)
+{
+    return QString("%1@%2x%3").arg(url).arg(size.width()).arg(size.height());
+}
+
+QString IconCache::pathFor(const QString &key) const
+{
+    QByteArray hash = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return dir + "/" + QString::fromLatin1(hash) + ".icon";
+}
+
+QImage IconCache::loadFromDisk(const QString &key) const
+{
+    QFile file(pathFor(key));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QImage();
+    }
+
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint32 width = 0;
+    qint32 height = 0;
+    QByteArray pixels;
+    in >> magic >> version >> width >> height >> pixels;
+
+    if (in.status() != QDataStream::Ok || magic != ICON_MAGIC || version != ICON_VERSION
+        || width <= 0 || height <= 0 || pixels.size() != width * height * 4) {
+        return QImage();
+    }
+
+    // Raw premultiplied pixels, so no image decode is needed
+    QImage image(width, height, QImage::Format_ARGB32_Premultiplied);
+    for (int y = 0; y < height; ++y) {
+        memcpy(image.scanLine(y), pixels.constData() + y * width * 4, width * 4);
+    }
+    return image;
+}
+
+void IconCache::storeOnDisk(const QString &key, const QImage &image) const
+{
+    QByteArray pixels;
+    pixels.reserve(image.width() * image.height() * 4);
+    for (int y = 0; y < image.height(); ++y) {
+        pixels.append(reinterpret_cast<const char *>(image.constScanLine(y)), image.width() * 4);
+    }
+
+    QSaveFile file(pathFor(key));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+
+    QDataStream out(&file);
+    out << ICON_MAGIC << ICON_VERSION << qint32(image.width()) << qint32(image.height()) << pixels;
+    file.commit();
+}
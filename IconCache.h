@@ -0,0 +1,57 @@
+#ifndef ICONCACHE_H
+#define ICONCACHE_H
+
+#include <QObject>
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QPixmap>
+#include <QSize>
+#include <QNetworkReply>
+
+// Process-wide two-tier cache of scaled icons keyed by URL and target size.
+// Scaled pixmaps live in an in-memory LRU, decoded pixels at the target size
+// are kept on disk, and concurrent requests for one URL share a single fetch.
+class IconCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static IconCache *instance();
+
+    // Returns true and fills pixmap on a hit, otherwise starts or joins a fetch
+    bool lookup(const QString &url, const QSize &size, QPixmap *pixmap);
+
+    // Seeds the in-memory tier with an icon decoded elsewhere
+    void insert(const QString &url, const QSize &size, const QImage &image);
+
+signals:
+    // Emitted once a fetched icon has been decoded and scaled
+    void iconReady(const QString &url, const QSize &size, const QPixmap &pixmap);
+
+    // Emitted instead when the download or the decode of an icon failed
+    void iconFailed(const QString &url, const QSize &size);
+
+private slots:
+    void onDownloadFinished(QNetworkReply *reply);
+
+    // Runs on the GUI thread once a worker has decoded and scaled an icon
+    void onIconDecoded(const QString &url, const QSize &size, const QImage &image);
+
+    // Runs on the GUI thread for every size waiting on a failed icon
+    void onIconFailed(const QString &url, const QList<QSize> &sizes, const QString &reason);
+
+private:
+    explicit IconCache(QObject *parent = nullptr);
+
+    QCache<QString, QPixmap> memory;
+    QHash<QString, QList<QSize>> inFlight;
+    QString dir;
+
+    static QString keyFor(const QString &url, const QSize &size);
+    QString pathFor(const QString &key) const;
+    QImage loadFromDisk(const QString &key) const;
+    void storeOnDisk(const QString &key, const QImage &image) const;
+};
+
+#endif // ICONCACHE_H
@@ -0,0 +1,92 @@
+#include "IdleSchedule.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QStringList>
+
+namespace {
+static const int DAY_MS = 24 * 60 * 60 * 1000;
+}
+
+IdleSchedule::IdleSchedule(QObject *parent)
+    : QObject(parent),
+    clock(&QDateTime::currentDateTime)
+{
+    boundaryTimer.setSingleShot(true);
+    // Seconds late is fine and lets the OS coalesce the wake-up
+    boundaryTimer.setTimerType(Qt::VeryCoarseTimer);
+    connect(&boundaryTimer, &QTimer::timeout, this, &IdleSchedule::update);
+}
+
+void IdleSchedule::setClock(Clock now)
+{
+    clock = std::move(now);
+    externalClock = true;
+    boundaryTimer.stop();
+}
+
+void IdleSchedule::check()
+{
+    if (enabled) {
+        update();
+    }
+}
+
+bool IdleSchedule::setWindow(const QString &window)
+{
+    enabled = false;
+    if (window.isEmpty()) {
+        return false;
+    }
+
+    const QStringList bounds = window.split('-');
+    if (bounds.size() == 2) {
+        begin = QTime::fromString(bounds[0].trimmed(), "HH:mm");
+        end = QTime::fromString(bounds[1].trimmed(), "HH:mm");
+        enabled = begin.isValid() && end.isValid() && begin != end;
+    }
+    if (!enabled) {
+        qInfo() << "Ignoring invalid idle window" << window;
+    }
+    return enabled;
+}
+
+bool IdleSchedule::isIdle() const
+{
+    return idle;
+}
+
+void IdleSchedule::start()
+{
+    if (enabled) {
+        update();
+    }
+}
+
+bool IdleSchedule::contains(const QTime &time) const
+{
+    if (begin < end) {
+        return time >= begin && time < end;
+    }
+    return time >= begin || time < end;
+}
+
+void IdleSchedule::update()
+{
+    const QTime now = clock().time();
+    const bool nowIdle = contains(now);
+
+    // Sleep until the next boundary, begin or end, whichever applies; an
+    // external clock is checked by its owner instead
+    if (!externalClock) {
+        int delay = now.msecsTo(nowIdle ? end : begin);
+        if (delay <= 0) {
+            delay += DAY_MS;
+        }
+        boundaryTimer.start(delay);
+    }
+
+    if (nowIdle != idle) {
+        idle = nowIdle;
+        emit idleChanged(idle);
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef IDLESCHEDULE_H
+#define IDLESCHEDULE_H
+
+#include <QDateTime>
+#include <QObject>
+#include <QTime>
+#include <QTimer>
+#include <functional>
+
+// Daily window during which nobody looks at the screen, e.g. 23:00-06:30.
+// The window may span midnight. A single coarse timer wakes up at each
+// boundary, so the schedule itself costs two wake-ups a day.
+class IdleSchedule : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Clock = std::function<QDateTime()>;
+
+    explicit IdleSchedule(QObject *parent = nullptr);
+
+    // Replaces the wall clock and stops the boundary timer, so the caller
+    // calls check() as its clock advances
+    void setClock(Clock now);
+
+    // Enters or leaves the window if the clock has crossed a boundary
+    void check();
+
+    // Parses "HH:mm-HH:mm"; an empty or invalid window disables idling
+    bool setWindow(const QString &window);
+
+    bool isIdle() const;
+
+    // Emits idleChanged(true) right away when started inside the window
+    void start();
+
+signals:
+    void idleChanged(bool idle);
+
+private:
+    QTime begin;
+    QTime end;
+    bool enabled = false;
+    bool idle = false;
+    QTimer boundaryTimer;
+    Clock clock;
+    bool externalClock = false;
+
+    bool contains(const QTime &time) const;
+    void update();
+};
+
+#endif // IDLESCHEDULE_H
@@ -1,37 +1,60 @@
 #include "ImageDownloader.h"
-#include <QNetworkRequest>
-#include <QUrl>
+#include "IconCache.h"
 
 ImageDownloader::ImageDownloader(QObject *parent)
-    : QObject(parent),
-    networkManager(new QNetworkAccessManager(this))
+    : QObject(parent)
 {
-    connect(networkManager, &QNetworkAccessManager::finished,
-            this, &ImageDownloader::onDownloadFinished);
+    connect(IconCache::instance(), &IconCache::iconReady,
+            this, &ImageDownloader::onIconReady);
+    connect(IconCache::instance(), &IconCache::iconFailed,
+            this, &ImageDownloader::onIconFailed);
 }
 
 ImageDownloader::~ImageDownloader()
 {
-    delete networkManager;
 }
 
-void ImageDownloader::downloadImage(const QString &url)
+void ImageDownloader::downloadImage(const QString &url, const QSize &size)
 {
-    QNetworkRequest request(url);
-    networkManager->get(request);
+    if (IconCache::instance()->lookup(url, size, &pixmap)) {
+        pendingUrl.clear();
+        pixmapUrl = url;
+        emit imageDownloaded();
+        return;
+    }
+
+    pendingUrl = url;
+    pendingSize = size;
 }
 
-void ImageDownloader::onDownloadFinished(QNetworkReply *reply)
+void ImageDownloader::onIconReady(const QString &url, const QSize &size, const QPixmap &icon)
 {
-    if (reply->error() == QNetworkReply::NoError) {
-        QByteArray imageData = reply->readAll();
-        pixmap.loadFromData(imageData);
-        emit imageDownloaded();
+    if (url != pendingUrl || size != pendingSize) {
+        return;
     }
-    reply->deleteLater();
+
+    pendingUrl.clear();
+    pixmapUrl = url;
+    pixmap = icon;
+    emit imageDownloaded();
+}
+
+void ImageDownloader::onIconFailed(const QString &url, const QSize &size)
+{
+    if (url != pendingUrl || size != pendingSize) {
+        return;
+    }
+
+    pendingUrl.clear();
+    emit imageFailed();
 }
 
 QPixmap ImageDownloader::getPixmap() const
 {
     return pixmap;
 }
+
+QString ImageDownloader::getUrl() const
+{
+    return pixmapUrl;
+}
@@ -3,8 +3,7 @@
 
 #include <QObject>
 #include <QPixmap>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
+#include <QSize>
 
 class ImageDownloader : public QObject
 {
@@ -14,22 +13,34 @@ public:
     explicit ImageDownloader(QObject *parent = nullptr);
     ~ImageDownloader();
 
-    // Initiates the download of an image from the given URL
-    void downloadImage(const QString &url);
+    // Requests the image at the given URL scaled to fit size, served from
+    // the shared icon cache when it has been seen before
+    void downloadImage(const QString &url, const QSize &size);
 
-    // Retrieves the downloaded pixmap
+    // Retrieves the downloaded pixmap, already scaled to the requested size
     QPixmap getPixmap() const;
 
+    // URL the current pixmap was loaded from
+    QString getUrl() const;
+
 signals:
     // Signal emitted when the image is downloaded
     void imageDownloaded();
 
+    // Emitted when the image could not be loaded; the previous pixmap stays
+    void imageFailed();
+
 private slots:
-    // Slot to handle the finished download
-    void onDownloadFinished(QNetworkReply *reply);
+    // Slot to handle an icon becoming available in the shared cache
+    void onIconReady(const QString &url, const QSize &size, const QPixmap &icon);
+
+    // Slot to give up on an icon the shared cache could not load
+    void onIconFailed(const QString &url, const QSize &size);
 
 private:
-    QNetworkAccessManager *networkManager;
+    QString pendingUrl;
+    QSize pendingSize;
+    QString pixmapUrl;
     QPixmap pixmap;
 };
 
@@ -9,106 +9,149 @@
 #include <QLabel>
 #include <QCoreApplication>
 #include <QUrl>
-#include <algorithm>
 #include <QFile>
+#include <QStandardPaths>
+#include <QResource>
+#include <QScreen>
 
+#include "BackgroundAssets.h"
 #include "ImageDownloader.h"
-#include "XmlReader.h"
+#include "IconCache.h"
+#include "EnvVars.h"
+#include "Metrics.h"
+#include "Trace.h"
 
 namespace {
-bool compareByDate(const ForecastItem &a, const ForecastItem &b) {
-    return a.date < b.date;
+Metrics::Histogram &slotDuration(const char *slot) {
+    return Metrics::histogram("pidashboard_gui_update_duration_seconds",
+                              "GUI thread time spent in MainWindow update slots.",
+                              QString("slot=\"%1\"").arg(slot));
 }
 
 QString roundQString(const QString &str) {
     return QString::number(qRound(str.toFloat()));
 }
 
-void clearLayout(QLayout *layout) {
-    while (QLayoutItem *item = layout->takeAt(0)) {
-        if (QWidget *widget = item->widget()) {
-            widget->deleteLater();
-        }
-        delete item;
-    }
-}
-
 static const int WINDOW_WIDTH = 800;
 static const int WINDOW_HEIGHT = 480;
-static const int NEWS_MAX_ITEMS = 8;
+static const int NEWS_MAX_ITEMS = FeedFetcher::NEWS_MAX_ITEMS;
+// Aggregator source holding the snapshot headlines; feeds follow it
+static const int SNAPSHOT_NEWS_SOURCE = 0;
 static const int ICON_SIZE = 30;
-
-static const QUrl NEWS_URL("https://feeds.bbci.co.uk/news/world/rss.xml");
-static QUrl WEATHER_URL;
-static QUrl FORECAST_URL;
+// Clock ticks between host health samples; rates are averaged over them
+static const int SYSTEM_STATS_INTERVAL_TICKS = 5;
+static const int METRICS_DEFAULT_PORT = 9101;
+static const int METRICS_DEFAULT_DUMP_SECONDS = 300;
+// Older forecasts would show days that have already passed
+static const qint64 SNAPSHOT_MAX_AGE_SECONDS = 12 * 60 * 60;
+
+enum ContentPart {
+    NEWS_PART = 1 << 0,
+    WEATHER_PART = 1 << 1,
+    FORECAST_PART = 1 << 2,
+    ICON1_PART = 1 << 3,
+    ICON2_PART = 1 << 4,
+    ICON3_PART = 1 << 5,
+    ALL_PARTS = (1 << 6) - 1
+};
 }
 
 MainWindow::MainWindow(const std::map<QString, QString> &envVars, QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
-    , newsReader(this)
-    , weatherReader(this)
-    , forecastReader(this)
     , downloaderDay1(this)
     , downloaderDay2(this)
     , downloaderDay3(this)
+    , blockMonitor(this)
+    , metricsServer(this)
+    , snapshot(QString(), this)
+    , newsAggregator(NEWS_MAX_ITEMS)
+    , idleSchedule(this)
+    , frame(this)
+    , clock([]() { return QDateTime::currentDateTime(); })
 {
-    WEATHER_URL = QUrl(QString("https://api.openweathermap.org/data/2.5/weather?zip=%1&mode=xml&units=%2&appid=%3").arg(
-        envVars.at("ZIP"),
-        envVars.at("UNIT"),
-        envVars.at("OW_API_KEY")
-    ));
-    FORECAST_URL = QUrl(QString("https://api.weatherapi.com/v1/forecast.xml?key=%1&q=%2&days=3").arg(
-        envVars.at("W_API_KEY"),
-        envVars.at("ZIP").split(",")[0]
-    ));
+    // Icons are fetched locally in every mode; they are cached and not metered
+    iconUrlPrefix = envString(envVars, "ICON_URL_PREFIX", QString());
+
+    // Enable before anything is fetched so the first refresh is traced
+    auto trace = envVars.find("TRACE_FILE");
+    if (trace != envVars.end()) {
+        traceFile = trace->second;
+        Trace::setEnabled(true);
+    }
 
     ui->setupUi(this);
     setupWindow();
     setupBackground();
     setupFonts();
+    setupNewsPanel();
+    setupSystemPanel(envVars);
+    setupHistoryPanel(envVars);
+    frame.watch(this);
     setupTimers();
-
-    // Connect newsReader to onNewsLoaded
-    connect(&newsReader, &XmlReader::feedLoaded, this, &MainWindow::onNewsLoaded);
-    connect(&newsReader, &XmlReader::errorOccurred, this, &MainWindow::onErrorQuit);
-
-    newsReader.loadFeed(NEWS_URL, XmlType::NEWS);
-
-    // Connect weatherReader to onWeatherLoaded
-    connect(&weatherReader, &XmlReader::feedLoaded, this, &MainWindow::onWeatherLoaded);
-    connect(&weatherReader, &XmlReader::errorOccurred, this, &MainWindow::onErrorQuit);
-
-    weatherReader.loadFeed(WEATHER_URL, XmlType::WEATHER);
-
-    // Connect forecastReader to onForecastLoaded
-    connect(&forecastReader, &XmlReader::feedLoaded, this, &MainWindow::onForecastLoaded);
-    connect(&forecastReader, &XmlReader::errorOccurred, this, &MainWindow::onErrorQuit);
-
-    forecastReader.loadFeed(FORECAST_URL, XmlType::FORECAST);
+    setupMetrics(envVars);
+
+    // Either fetch the feeds here or receive them from a feed daemon that
+    // fetches once for every screen
+    auto feedServer = envVars.find("FEED_SERVER");
+    if (feedServer != envVars.end() && !feedServer->second.isEmpty()) {
+        subscriber = new FeedSubscriber(feedServer->second, this);
+        connect(subscriber, &FeedSubscriber::resultLoaded, this, &MainWindow::onResultLoaded);
+        // Announced by the daemon before it sends any news
+        connect(subscriber, &FeedSubscriber::newsSourcesAnnounced, this, [this](int count) {
+            newsSourceCount = count;
+        });
+    } else {
+        fetcher = new FeedFetcher(envVars, this);
+        connect(fetcher, &FeedFetcher::fetchStarted, &blockMonitor, &GuiBlockMonitor::startWindow);
+        connect(fetcher, &FeedFetcher::resultLoaded, this, &MainWindow::onResultLoaded);
+        newsSourceCount = fetcher->newsSourceCount();
+    }
 
     // Download weather icons
     connect(&downloaderDay1, &ImageDownloader::imageDownloaded, this, [this]() {
-        ui->day1icon->setPixmap(
-            downloaderDay1.getPixmap().scaled(ICON_SIZE, ICON_SIZE, Qt::KeepAspectRatio, Qt::SmoothTransformation)
-            );
+        frame.setPixmap(ui->day1icon, downloaderDay1.getPixmap());
+        snapshot.setIcon(0, downloaderDay1.getUrl(), QSize(ICON_SIZE, ICON_SIZE), downloaderDay1.getPixmap().toImage());
+        markShown(ICON1_PART);
     });
 
     connect(&downloaderDay2, &ImageDownloader::imageDownloaded, this, [this]() {
-        ui->day2icon->setPixmap(
-            downloaderDay2.getPixmap().scaled(ICON_SIZE, ICON_SIZE, Qt::KeepAspectRatio, Qt::SmoothTransformation)
-            );
+        frame.setPixmap(ui->day2icon, downloaderDay2.getPixmap());
+        snapshot.setIcon(1, downloaderDay2.getUrl(), QSize(ICON_SIZE, ICON_SIZE), downloaderDay2.getPixmap().toImage());
+        markShown(ICON2_PART);
     });
 
     connect(&downloaderDay3, &ImageDownloader::imageDownloaded, this, [this]() {
-        ui->day3icon->setPixmap(
-            downloaderDay3.getPixmap().scaled(ICON_SIZE, ICON_SIZE, Qt::KeepAspectRatio, Qt::SmoothTransformation)
-            );
+        frame.setPixmap(ui->day3icon, downloaderDay3.getPixmap());
+        snapshot.setIcon(2, downloaderDay3.getUrl(), QSize(ICON_SIZE, ICON_SIZE), downloaderDay3.getPixmap().toImage());
+        markShown(ICON3_PART);
     });
+
+    // A missing icon keeps the previous one and must not hold back the frame
+    connect(&downloaderDay1, &ImageDownloader::imageFailed, this, [this]() { markShown(ICON1_PART); });
+    connect(&downloaderDay2, &ImageDownloader::imageFailed, this, [this]() { markShown(ICON2_PART); });
+    connect(&downloaderDay3, &ImageDownloader::imageFailed, this, [this]() { markShown(ICON3_PART); });
+
+    // Show the last known state first, fresh data replaces it as it arrives
+    restoreSnapshot();
+    if (fetcher) {
+        fetcher->start();
+    } else {
+        subscriber->start();
+    }
+
+    // Overnight the display is blanked and polling slows down
+    backlightPath = envString(envVars, "IDLE_BACKLIGHT", QString());
+    connect(&idleSchedule, &IdleSchedule::idleChanged, this, &MainWindow::setIdle);
+    idleSchedule.setWindow(envString(envVars, "IDLE_HOURS", QString()));
+    idleSchedule.start();
 }
 
 MainWindow::~MainWindow()
 {
+    if (!traceFile.isEmpty()) {
+        Trace::dump(traceFile);
+    }
     delete ui;
 }
 
@@ -119,16 +162,38 @@ void MainWindow::setupWindow()
 
 void MainWindow::setupBackground()
 {
-    QPixmap background(":/background.jpg");
-    background = background.scaled(this->size(), Qt::IgnoreAspectRatio);
+    // Sized for the screen the window will fill; before showFullScreen() the
+    // window itself does not have its final size yet
+    QScreen *screen = QGuiApplication::primaryScreen();
+    const QSize screenSize = screen ? screen->size() : size();
+
+    QImage background;
+#ifdef PIDASHBOARD_PREBUILT_BACKGROUND
+    // Pixels prepared at build time are painted in place, nothing is decoded
+    for (const BackgroundAsset *asset = BACKGROUND_ASSETS; asset->pixels; ++asset) {
+        if (QSize(asset->width, asset->height) == screenSize) {
+            background = QImage(asset->pixels, asset->width, asset->height, asset->width * 4, QImage::Format_RGB32);
+            break;
+        }
+    }
+#endif
+    if (background.isNull()) {
+        background = QImage(":/background.jpg").scaled(screenSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+
     QPalette palette;
-    palette.setBrush(QPalette::Window, background);
+    palette.setBrush(QPalette::Window, QBrush(background));
     this->setPalette(palette);
 }
 
 void MainWindow::setupFonts()
 {
-    int fontId = QFontDatabase::addApplicationFont(":/Roboto-Round.ttf");
+    // Stored uncompressed, so the font is read straight from the executable
+    QResource resource(":/Roboto-Round.ttf");
+    const QByteArray font = resource.compressionAlgorithm() == QResource::NoCompression
+        ? QByteArray::fromRawData(reinterpret_cast<const char *>(resource.data()), int(resource.size()))
+        : resource.uncompressedData();
+    int fontId = QFontDatabase::addApplicationFontFromData(font);
     if (fontId < 0) {
         qInfo() << "Failed to load Roboto-Round.ttf!";
         return;
@@ -136,19 +201,8 @@ void MainWindow::setupFonts()
 
     fontFamily = QFontDatabase::applicationFontFamilies(fontId).at(0);
 
-    // Large time
-    QFont timeFontLg(fontFamily, 72);
-    ui->timeText->setFont(timeFontLg);
-
-    // Seconds & AM/PM
-    QFont timeFontSm(fontFamily, 24);
-    ui->secondsText->setFont(timeFontSm);
-    ui->periodText->setFont(timeFontSm);
-
-    // Date
-    QFont dateFont(fontFamily, 18);
-    ui->dateText->setFont(dateFont);
-    ui->dateText->setText(QDateTime::currentDateTime().toString("dddd, MMMM dd"));
+    // Clock
+    ui->clock->setFontFamily(fontFamily);
 
     // Current weather
     QFont weatherFontLg(fontFamily, 48);
@@ -159,117 +213,355 @@ void MainWindow::setupFonts()
     ui->weatherText->setFont(weatherFontSm);
 }
 
-void MainWindow::setupTimers()
+void MainWindow::setupNewsPanel()
 {
-    QTimer *timer1s = new QTimer(this);
-    connect(timer1s, &QTimer::timeout, this, [this]() {
-        updateDateTimeDisplay();
-    });
-    timer1s->start(1000);
+    // One stylesheet on the container instead of one per headline label
+    ui->column2->setStyleSheet(ui->column2->styleSheet() +
+        "QLabel {"
+        "   background-color: rgba(0, 0, 0, 0);"
+        "   border-radius: 0px;"
+        "   color: white;"
+        "}"
+        );
+
+    QFont newsFont(fontFamily, 12);
+    for (int i = 0; i < NEWS_MAX_ITEMS; ++i) {
+        QLabel *label = new QLabel(ui->column2);
+        label->setWordWrap(true);
+        label->setFont(newsFont);
+        label->hide();
+        ui->column2->layout()->addWidget(label);
+        newsLabels.append(label);
+    }
+}
 
-    QTimer *timer10m = new QTimer(this);
-    connect(timer10m, &QTimer::timeout, this, [this]() {
-        newsReader.loadFeed(NEWS_URL, XmlType::NEWS);
-        weatherReader.loadFeed(WEATHER_URL, XmlType::WEATHER);
-        forecastReader.loadFeed(FORECAST_URL, XmlType::FORECAST);
+void MainWindow::setupSystemPanel(const std::map<QString, QString> &envVars)
+{
+    if (envInt(envVars, "SYSTEM_STATS", 1) == 0) {
+        return;
+    }
 
+    // Transparent like the weather labels, the column frame style would apply otherwise
+    systemLabel = new QLabel(ui->column3);
+    systemLabel->setFont(QFont(fontFamily, 11));
+    systemLabel->setAlignment(Qt::AlignCenter);
+    systemLabel->setStyleSheet("background-color: rgba(0, 0, 0, 0); border-radius: 0px; color: white;");
+    QBoxLayout *layout = qobject_cast<QBoxLayout *>(ui->column3->layout());
+    layout->insertWidget(layout->indexOf(ui->weatherText) + 1, systemLabel);
+
+    // The first sample only sets the baseline for load and throughput
+    systemClock.start();
+    systemStats.sample(systemClock.nsecsElapsed());
+}
+
+void MainWindow::setupHistoryPanel(const std::map<QString, QString> &envVars)
+{
+    // Readings arrive in UNIT, so a history kept in another unit starts over
+    const TemperatureHistory::Unit unit = TemperatureHistory::unitFor(envString(envVars, "UNIT", "metric"));
+    if (envInt(envVars, "TEMPERATURE_HISTORY", 1) == 0 || !temperatureHistory.open(unit)) {
+        return;
+    }
+
+    // Between the weather and the system stats
+    sparkline = new SparklineWidget(ui->column3);
+    QBoxLayout *layout = qobject_cast<QBoxLayout *>(ui->column3->layout());
+    layout->insertWidget(layout->indexOf(ui->weatherText) + 1, sparkline);
+    sparkline->setHistory(&temperatureHistory, TemperatureHistory::TEMPERATURE);
+}
+
+void MainWindow::updateSystemStats()
+{
+    static Metrics::Histogram &duration = slotDuration("system");
+    Metrics::ScopedTimer timer(duration);
+    Trace::Span span("MainWindow::updateSystemStats", "gui");
+
+    const SystemStats::Sample sample = systemStats.sample(systemClock.nsecsElapsed());
+    QStringList parts;
+    if (sample.hasTemperature) {
+        parts << QString("%1°C").arg(qRound(sample.temperatureC));
+    }
+    if (sample.cpuLoad >= 0) {
+        parts << QString("CPU %1%").arg(qRound(sample.cpuLoad * 100));
+    }
+    if (sample.memTotalKb > 0 && sample.memAvailableKb >= 0) {
+        parts << QString("RAM %1%").arg(qRound(100.0 * (sample.memTotalKb - sample.memAvailableKb) / sample.memTotalKb));
+    }
+    QString text = parts.join(QString::fromUtf8(" · "));
+    if (sample.rxBytesPerSecond >= 0) {
+        text += QString("\nNet %1 / %2 KB/s").arg(qRound(sample.rxBytesPerSecond / 1024)).arg(qRound(sample.txBytesPerSecond / 1024));
+    }
+
+    // Only repainted when the text changed
+    frame.setText(systemLabel, text);
+}
+
+void MainWindow::setupMetrics(const std::map<QString, QString> &envVars)
+{
+    Metrics::callbackCounter("pidashboard_feed_cache_hits_total", "Feed requests answered with 304 Not Modified.",
+                             []() { return FeedCache::stats().hits; });
+    Metrics::callbackCounter("pidashboard_feed_cache_misses_total", "Feed requests that transferred a body.",
+                             []() { return FeedCache::stats().misses; });
+    Metrics::callbackCounter("pidashboard_feed_cache_bytes_saved_total", "Body bytes not transferred thanks to 304s.",
+                             []() { return FeedCache::stats().bytesSaved; });
+
+    Metrics::Gauge &worstBlock = Metrics::gauge("pidashboard_gui_block_worst_seconds",
+                                                "Worst GUI thread stall during the last refresh.");
+    connect(&blockMonitor, &GuiBlockMonitor::windowFinished, this, [&worstBlock](double worstBlockMs) {
+        worstBlock.set(worstBlockMs / 1000.0);
     });
-    timer10m->start(10 * 60 * 1000);
 
-    // Initialize once
-    updateDateTimeDisplay();
+    auto path = envVars.find("METRICS_FILE");
+    QString dumpPath = path != envVars.end()
+        ? path->second
+        : QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/metrics.prom";
+
+    metricsServer.listen(envInt(envVars, "METRICS_PORT", METRICS_DEFAULT_PORT));
+    metricsServer.startFileDump(dumpPath, envInt(envVars, "METRICS_DUMP_SECONDS", METRICS_DEFAULT_DUMP_SECONDS));
 }
 
-void MainWindow::updateDateTimeDisplay()
+void MainWindow::restoreSnapshot()
 {
-    QDateTime currentDateTime = QDateTime::currentDateTime();
-    int hour = currentDateTime.time().hour();
-    QString hour12 = QString::number((hour % 12 == 0) ? 12 : hour % 12);
-    ui->timeText->setText(hour12 + ":" + currentDateTime.time().toString("mm"));
-    ui->secondsText->setText(currentDateTime.time().toString("ss"));
-    ui->dateText->setText(currentDateTime.toString("dddd, MMMM dd"));
+    if (!snapshot.load(SNAPSHOT_MAX_AGE_SECONDS)) {
+        return;
+    }
+
+    // Icons go into the cache so the forecast finds them without a fetch
+    for (int slot = 0; slot < StateSnapshot::ICON_SLOTS; ++slot) {
+        const StateSnapshot::Icon icon = snapshot.icon(slot);
+        IconCache::instance()->insert(icon.url, icon.size, icon.image);
+    }
+
+    // Held as an extra source until the real ones have all loaded
+    if (auto news = snapshot.result(XmlType::NEWS).news) {
+        showingSnapshotNews = true;
+        showNews(SNAPSHOT_NEWS_SOURCE, *news);
+    }
+    if (auto weather = snapshot.result(XmlType::WEATHER).weather) {
+        showWeather(*weather);
+    }
+    if (auto forecast = snapshot.result(XmlType::FORECAST).forecast) {
+        showForecast(*forecast);
+    }
 }
 
-void MainWindow::onNewsLoaded()
+void MainWindow::setupTimers()
 {
-    auto items = newsReader.getItems();
-    int maxItems = qMin(items.size(), NEWS_MAX_ITEMS);
-    QFont newsFont(fontFamily, 12);
-    clearLayout(ui->column2->layout());
+    clockTimer.setInterval(1000);
+    connect(&clockTimer, &QTimer::timeout, this, &MainWindow::tick);
+
+    // Report clock paint cost and frame work alongside each refresh measurement
+    connect(&blockMonitor, &GuiBlockMonitor::windowFinished, this, [this]() {
+        const ClockWidget::PaintStats &paint = ui->clock->paintStats();
+        qInfo() << "Clock paints:" << paint.paints << "avg"
+                << (paint.paints ? paint.totalNs / paint.paints / 1000 : 0) << "us, max" << paint.maxNs / 1000 << "us";
+
+        const FrameBatcher::Stats &stats = frame.stats();
+        qInfo() << "Refresh frames:" << stats.commits - lastFrameStats.commits << "commits,"
+                << stats.changes - lastFrameStats.changes << "changes,"
+                << stats.layoutPasses - lastFrameStats.layoutPasses << "layout passes,"
+                << stats.repaints - lastFrameStats.repaints << "repaints";
+        lastFrameStats = stats;
+    });
 
-    for (int i = 0; i < maxItems; ++i) {
-        if (!std::holds_alternative<NewsItem>(items[i])) {
-            continue;
+    startClock();
+}
+
+void MainWindow::startClock()
+{
+    updateDateTimeDisplay();
+
+    // Tick just after each second boundary so the seconds never lag
+    const int toNextSecond = 1000 - QTime::currentTime().msec();
+    QTimer::singleShot(toNextSecond, Qt::PreciseTimer, this, [this]() {
+        // A simulated clock only advances through tick()
+        if (idleSchedule.isIdle() || externalClock) {
+            return;
         }
+        updateDateTimeDisplay();
+        clockTimer.start();
+    });
+}
 
-        const auto &newsItem = std::get<NewsItem>(items[i]);
-        QLabel *label = new QLabel(newsItem.title, ui->column2);
-        label->setStyleSheet(
-            "QFrame {"
-            "   background-color: rgba(0, 0, 0, 0);"
-            "   border-radius: 0px;"
-            "}"
-            "QLabel {"
-            "   color: white;"
-            "}"
-            );
-        label->setWordWrap(true);
-        label->setFont(newsFont);
-        ui->column2->layout()->addWidget(label);
+void MainWindow::setIdle(bool idle)
+{
+    static Metrics::Counter &avoided = Metrics::counter("pidashboard_idle_wakeups_avoided_total",
+                                                        "Clock ticks and feed fetches skipped while idle.");
+
+    if (idle) {
+        qInfo() << "Idle, blanking the display";
+        clockTimer.stop();
+        idleSince = clock();
+        if (fetcher) {
+            deferredBeforeIdle = fetcher->deferredFetches();
+            fetcher->setIdle(true);
+        }
+
+        // Hidden widgets are not repainted, whatever data arrives meanwhile
+        ui->centralwidget->hide();
+        dayPalette = palette();
+        QPalette blank;
+        blank.setColor(QPalette::Window, Qt::black);
+        setPalette(blank);
+        setBacklight(false);
+        return;
     }
+
+    // One clock tick per second plus the fetches the long interval skipped
+    const qint64 idleSeconds = idleSince.secsTo(clock());
+    const quint64 wakeups = quint64(idleSeconds) + (fetcher ? fetcher->deferredFetches() - deferredBeforeIdle : 0);
+    avoided.add(wakeups);
+    qInfo() << "Awake after" << idleSeconds / 60 << "min idle, avoided" << wakeups << "wake-ups,"
+            << (idleSeconds > 0 ? wakeups * 60.0 / idleSeconds : 0.0) << "per minute";
+
+    setBacklight(true);
+    setPalette(dayPalette);
+    ui->centralwidget->show();
+
+    // One coalesced refresh instead of the fetches that were deferred
+    if (fetcher) {
+        fetcher->setIdle(false);
+        fetcher->start();
+    }
+    startClock();
 }
 
-void MainWindow::onWeatherLoaded()
+void MainWindow::setBacklight(bool on)
 {
-    auto items = weatherReader.getItems();
+    // E.g. /sys/class/backlight/rpi_backlight/bl_power, where 1 is off
+    if (backlightPath.isEmpty()) {
+        return;
+    }
+    QFile file(backlightPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qInfo() << "Cannot switch the backlight:" << file.errorString();
+        return;
+    }
+    file.write(on ? "0" : "1");
+}
 
-    // For each variant in items: TemperatureItem, FeelsLikeItem, WeatherItem
-    for (auto &item : items) {
-        if (std::holds_alternative<TemperatureItem>(item)) {
-            QString temperature = std::get<TemperatureItem>(item).temperature;
-            ui->currentTempText->setText(roundQString(temperature) + "°");
-        }
-        else if (std::holds_alternative<FeelsLikeItem>(item)) {
-            QString feelsLike = std::get<FeelsLikeItem>(item).feelsLike;
-            ui->feelsLikeText->setText("Feels like " + roundQString(feelsLike) + "°");
+void MainWindow::updateDateTimeDisplay()
+{
+    static Metrics::Histogram &duration = slotDuration("clock");
+    Metrics::ScopedTimer timer(duration);
+    Trace::Span span("MainWindow::updateDateTimeDisplay", "gui");
+
+    ui->clock->setDateTime(clock());
+}
+
+void MainWindow::onResultLoaded(XmlType type, int source, const FeedResult &result)
+{
+    switch (type) {
+    case XmlType::NEWS:
+        onNewsLoaded(source, result);
+        break;
+    case XmlType::WEATHER:
+        if (result.weather) {
+            showWeather(*result.weather);
+            temperatureHistory.appendWeather(quint32(clock().toSecsSinceEpoch()), *result.weather);
+            if (sparkline) {
+                sparkline->appended();
+            }
         }
-        else if (std::holds_alternative<WeatherItem>(item)) {
-            QString weather = std::get<WeatherItem>(item).weather;
-            weather[0] = weather[0].toUpper();
-            ui->weatherText->setText(weather);
+        snapshot.setResult(XmlType::WEATHER, result);
+        break;
+    case XmlType::FORECAST:
+        if (result.forecast) {
+            showForecast(*result.forecast);
+            temperatureHistory.appendForecast(*result.forecast);
         }
+        snapshot.setResult(XmlType::FORECAST, result);
+        break;
     }
 }
 
-void MainWindow::onForecastLoaded()
+void MainWindow::onNewsLoaded(int source, const FeedResult &result)
 {
-    const QLocale locale;
-    auto items = forecastReader.getItems();
+    bool changed = result.news && showNews(SNAPSHOT_NEWS_SOURCE + 1 + source, *result.news);
 
-    QList<ForecastItem> forecastList;
-    forecastList.reserve(items.size());
-    for (auto &variantItem : items) {
-        if (std::holds_alternative<ForecastItem>(variantItem)) {
-            forecastList.append(std::get<ForecastItem>(variantItem));
+    newsSourcesLoaded.insert(source);
+    if (showingSnapshotNews && newsSourcesLoaded.size() >= newsSourceCount) {
+        showingSnapshotNews = false;
+        changed |= showNews(SNAPSHOT_NEWS_SOURCE, NewsFeed());
+    }
+
+    if (changed) {
+        FeedResult merged;
+        merged.news = newsAggregator.headlines();
+        snapshot.setResult(XmlType::NEWS, merged);
+    }
+}
+
+bool MainWindow::showNews(int source, const NewsFeed &news)
+{
+    static Metrics::Histogram &duration = slotDuration("news");
+    Metrics::ScopedTimer timer(duration);
+    Trace::Span span("MainWindow::showNews", "gui");
+
+    markShown(NEWS_PART);
+
+    // Only slots whose headline moved or changed are touched
+    const QVector<int> changed = newsAggregator.update(source, news);
+    for (int slot : changed) {
+        if (slot < newsLabels.size()) {
+            setNewsSlot(slot, newsAggregator.headline(slot).title);
         }
     }
+    return !changed.isEmpty();
+}
+
+void MainWindow::setNewsSlot(int slot, const QString &title)
+{
+    // Unchanged headlines cause no relayout or repaint
+    QLabel *label = newsLabels[slot];
+    frame.setText(label, title);
+    frame.setVisible(label, !title.isEmpty());
+}
+
+void MainWindow::showWeather(const CurrentWeather &current)
+{
+    static Metrics::Histogram &duration = slotDuration("weather");
+    Metrics::ScopedTimer timer(duration);
+    Trace::Span span("MainWindow::showWeather", "gui");
+    markShown(WEATHER_PART);
+
+    // Fields missing from the document keep their previous text
+    if (!current.temperature.isEmpty()) {
+        frame.setText(ui->currentTempText, roundQString(current.temperature) + "°");
+    }
+    if (!current.feelsLike.isEmpty()) {
+        frame.setText(ui->feelsLikeText, "Feels like " + roundQString(current.feelsLike) + "°");
+    }
+    if (!current.weather.isEmpty()) {
+        QString weather = current.weather;
+        weather[0] = weather[0].toUpper();
+        frame.setText(ui->weatherText, weather);
+    }
+}
 
-    // Sort the forecast items
-    std::sort(forecastList.begin(), forecastList.end(), compareByDate);
+void MainWindow::showForecast(const Forecast &forecast)
+{
+    static Metrics::Histogram &duration = slotDuration("forecast");
+    Metrics::ScopedTimer timer(duration);
+    Trace::Span span("MainWindow::showForecast", "gui");
+
+    const QLocale locale;
 
-    if (forecastList.size() < 3) {
+    // The parser already keeps the days sorted by date
+    if (forecast.count < 3) {
         qInfo() << "Not enough forecast data; expected at least 3 days.";
         return;
     }
 
+    markShown(FORECAST_PART);
+
     // Day 1
-    updateForecastUI(forecastList[0], ui->day1hi, ui->day1lo, ui->day1prec, ui->day1icon, downloaderDay1, locale, nullptr);
+    updateForecastUI(forecast.days[0], ui->day1hi, ui->day1lo, ui->day1prec, ui->day1icon, downloaderDay1, locale, nullptr);
 
     // Day 2
-    updateForecastUI(forecastList[1], ui->day2hi, ui->day2lo, ui->day2prec, ui->day2icon, downloaderDay2, locale, ui->day2Text);
+    updateForecastUI(forecast.days[1], ui->day2hi, ui->day2lo, ui->day2prec, ui->day2icon, downloaderDay2, locale, ui->day2Text);
 
     // Day 3
-    updateForecastUI(forecastList[2], ui->day3hi, ui->day3lo, ui->day3prec, ui->day3icon, downloaderDay3, locale, ui->day3Text);
+    updateForecastUI(forecast.days[2], ui->day3hi, ui->day3lo, ui->day3prec, ui->day3icon, downloaderDay3, locale, ui->day3Text);
 }
 
 void MainWindow::updateForecastUI(
@@ -282,21 +574,74 @@ void MainWindow::updateForecastUI(
     const QLocale &locale,
     QLabel *dayLabel)
 {
-    hiLabel->setText(roundQString(item.maxTemp) + "°");
-    loLabel->setText(roundQString(item.minTemp) + "°");
-    precLabel->setText(item.rainChance + "%");
+    Trace::Span span("MainWindow::updateForecastUI", "gui");
+    frame.setText(hiLabel, roundQString(item.maxTemp) + "°");
+    frame.setText(loLabel, roundQString(item.minTemp) + "°");
+    frame.setText(precLabel, item.rainChance + "%");
 
     // If we also have a label to display day name
     if (dayLabel) {
         QDate date = QDate::fromString(item.date, "yyyy-MM-dd");
-        dayLabel->setText(locale.dayName(date.dayOfWeek(), QLocale::ShortFormat) + ".");
+        frame.setText(dayLabel, locale.dayName(date.dayOfWeek(), QLocale::ShortFormat) + ".");
     }
 
-    downloader.downloadImage("https:" + item.icon);
+    downloader.downloadImage(iconUrl(item.icon), QSize(ICON_SIZE, ICON_SIZE));
 }
 
-void MainWindow::onErrorQuit(const QString &error)
+QString MainWindow::iconUrl(const QString &icon) const
 {
-    qInfo() << "Error:" << error;
-    QApplication::quit();
+    // Icons are protocol-relative, e.g. //cdn.weatherapi.com/weather/64x64/day/113.png
+    if (iconUrlPrefix.isEmpty()) {
+        return "https:" + icon;
+    }
+    return iconUrlPrefix + QUrl("https:" + icon).path();
+}
+
+void MainWindow::refreshNow()
+{
+    // A subscriber shows whatever the daemon last fetched
+    if (fetcher) {
+        fetcher->start();
+    }
+}
+
+void MainWindow::setClock(Clock now)
+{
+    clock = std::move(now);
+    externalClock = true;
+    clockTimer.stop();
+    idleSchedule.setClock(clock);
+    idleSchedule.check();
+    updateDateTimeDisplay();
+}
+
+void MainWindow::tick()
+{
+    // The simulated clock also decides when the idle window begins and ends;
+    // like the wall clock it does not tick the display while idle
+    if (externalClock) {
+        idleSchedule.check();
+        if (idleSchedule.isIdle()) {
+            return;
+        }
+    }
+    updateDateTimeDisplay();
+    if (systemLabel && ++clockTicks % SYSTEM_STATS_INTERVAL_TICKS == 0) {
+        updateSystemStats();
+    }
+}
+
+void MainWindow::markShown(int part)
+{
+    shownParts |= part;
+    if (shownParts != ALL_PARTS) {
+        return;
+    }
+
+    // Queued so observers connected right after construction still see a
+    // completion from the startup snapshot. The frame is committed first,
+    // once the handler that completed it has queued its changes.
+    shownParts = 0;
+    QMetaObject::invokeMethod(&frame, &FrameBatcher::commit, Qt::QueuedConnection);
+    QMetaObject::invokeMethod(this, &MainWindow::contentComplete, Qt::QueuedConnection);
 }
@@ -5,8 +5,23 @@
 #include <QMainWindow>
 #include <QKeyEvent>
 #include <QLabel>
-#include "XmlReader.h"
+#include <QSet>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <functional>
 #include "ImageDownloader.h"
+#include "GuiBlockMonitor.h"
+#include "FeedFetcher.h"
+#include "FeedSubscriber.h"
+#include "MetricsServer.h"
+#include "Trace.h"
+#include "StateSnapshot.h"
+#include "NewsAggregator.h"
+#include "IdleSchedule.h"
+#include "FrameBatcher.h"
+#include "SystemStats.h"
+#include "TemperatureHistory.h"
+#include "SparklineWidget.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -22,11 +37,31 @@ public:
     MainWindow(const std::map<QString, QString> &envVars, QWidget *parent = nullptr);
     ~MainWindow();
 
+    using Clock = std::function<QDateTime()>;
+
+    // Fetches every feed now regardless of its schedule
+    void refreshNow();
+
+    // Replaces the wall clock and stops the tick timer, so the caller drives
+    // time with tick(), e.g. to run days of simulated time in a soak test.
+    // The idle window follows the same clock.
+    void setClock(Clock now);
+
+    // One second of the clock: the time display and the periodic samples
+    void tick();
+
+signals:
+    // Emitted each time the news, weather, forecast and all forecast icons
+    // have been updated since the previous emission
+    void contentComplete();
+
 protected:
-    // Overrides the keyPressEvent so that pressing q quits
+    // Overrides the keyPressEvent so that pressing q quits and t dumps the trace
     void keyPressEvent(QKeyEvent *event) override {
         if (event->key() == Qt::Key_Q) {
             QApplication::quit();
+        } else if (event->key() == Qt::Key_T && !traceFile.isEmpty()) {
+            Trace::dump(traceFile);
         } else {
             QMainWindow::keyPressEvent(event);
         }
@@ -34,24 +69,69 @@ protected:
 
 private:
     Ui::MainWindow *ui;
-    XmlReader newsReader;
-    XmlReader weatherReader;
-    XmlReader forecastReader;
     ImageDownloader downloaderDay1;
     ImageDownloader downloaderDay2;
     ImageDownloader downloaderDay3;
+    GuiBlockMonitor blockMonitor;
+    // Exactly one of them is set, depending on FEED_SERVER
+    FeedFetcher *fetcher = nullptr;
+    FeedSubscriber *subscriber = nullptr;
+    MetricsServer metricsServer;
+    StateSnapshot snapshot;
+    NewsAggregator newsAggregator;
+    IdleSchedule idleSchedule;
+    // Every label change goes through here; see FrameBatcher
+    FrameBatcher frame;
+    FrameBatcher::Stats lastFrameStats;
+    QTimer clockTimer;
+    Clock clock;
+    bool externalClock = false;
+    QPalette dayPalette;
+    QString backlightPath;
+    // Start of the current idle window and the fetches deferred before it
+    QDateTime idleSince;
+    quint64 deferredBeforeIdle = 0;
     QString fontFamily;
+    QString traceFile;
+    // Snapshot headlines shown until every source has loaded once
+    int newsSourceCount = 0;
+    QSet<int> newsSourcesLoaded;
+    bool showingSnapshotNews = false;
+    QString iconUrlPrefix;
+    int shownParts = 0;
+    QList<QLabel *> newsLabels;
+    // Host health under the weather, null when disabled
+    QLabel *systemLabel = nullptr;
+    SystemStats systemStats;
+    QElapsedTimer systemClock;
+    int clockTicks = 0;
+    // Readings kept across restarts and their sparkline, null when disabled
+    TemperatureHistory temperatureHistory;
+    SparklineWidget *sparkline = nullptr;
 
     void setupWindow();
     void setupBackground();
     void setupFonts();
+    void setupNewsPanel();
+    void setupSystemPanel(const std::map<QString, QString> &envVars);
+    void setupHistoryPanel(const std::map<QString, QString> &envVars);
     void setupTimers();
+    void setupMetrics(const std::map<QString, QString> &envVars);
+    void restoreSnapshot();
     void updateDateTimeDisplay();
+    void updateSystemStats();
+    void startClock();
+    void setIdle(bool idle);
+    void setBacklight(bool on);
 
-    void onNewsLoaded();
-    void onWeatherLoaded();
-    void onForecastLoaded();
-    void onErrorQuit(const QString &error);
+    void onResultLoaded(XmlType type, int source, const FeedResult &result);
+    void onNewsLoaded(int source, const FeedResult &result);
+    bool showNews(int source, const NewsFeed &news);
+    void setNewsSlot(int slot, const QString &title);
+    void showWeather(const CurrentWeather &current);
+    void showForecast(const Forecast &forecast);
+    QString iconUrl(const QString &icon) const;
+    void markShown(int part);
 
     void updateForecastUI(
         const ForecastItem &item,
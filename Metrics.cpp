@@ -0,0 +1,177 @@
+#include "Metrics.h"
+#include <QFile>
+#include <QMutex>
+#include <map>
+#include <memory>
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+const qint64 Metrics::Histogram::BOUNDS_NS[BUCKET_COUNT] = {
+    100000, 250000, 500000,
+    1000000, 2500000, 5000000,
+    10000000, 25000000, 50000000,
+    100000000, 250000000, 500000000,
+    1000000000, 2500000000LL, 5000000000LL,
+    10000000000LL
+};
+
+namespace {
+struct Series {
+    std::unique_ptr<Metrics::Counter> counter;
+    std::unique_ptr<Metrics::Gauge> gauge;
+    std::unique_ptr<Metrics::Histogram> histogram;
+    std::function<double()> read;
+};
+
+struct Family {
+    QByteArray help;
+    QByteArray type;
+    std::map<QString, Series> series;
+};
+
+struct Registry {
+    QMutex mutex;
+    std::map<QByteArray, Family> families;
+};
+
+Registry &registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+Series &findSeries(const char *name, const char *help, const char *type, const QString &labels)
+{
+    // Callers hold the registry mutex
+    Family &family = registry().families[name];
+    if (family.type.isEmpty()) {
+        family.help = help;
+        family.type = type;
+    }
+    return family.series[labels];
+}
+
+QByteArray seriesName(const QByteArray &name, const QString &labels, const QString &extraLabel = QString())
+{
+    QString all = labels;
+    if (!extraLabel.isEmpty()) {
+        all += (all.isEmpty() ? "" : ",") + extraLabel;
+    }
+    return all.isEmpty() ? name : name + "{" + all.toUtf8() + "}";
+}
+
+#ifdef Q_OS_LINUX
+double residentBytes()
+{
+    // The second field of statm is the resident set in pages
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    return fields.size() > 1 ? fields.at(1).toDouble() * sysconf(_SC_PAGESIZE) : 0;
+}
+#endif
+}
+
+void Metrics::Histogram::observeNs(qint64 ns)
+{
+    int bucket = 0;
+    while (bucket < BUCKET_COUNT && ns > BOUNDS_NS[bucket]) {
+        bucket++;
+    }
+    buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sumNs.fetch_add(quint64(qMax<qint64>(0, ns)), std::memory_order_relaxed);
+}
+
+Metrics::Counter &Metrics::counter(const char *name, const char *help, const QString &labels)
+{
+    QMutexLocker locker(&registry().mutex);
+    Series &series = findSeries(name, help, "counter", labels);
+    if (!series.counter) {
+        series.counter.reset(new Counter);
+    }
+    return *series.counter;
+}
+
+Metrics::Gauge &Metrics::gauge(const char *name, const char *help, const QString &labels)
+{
+    QMutexLocker locker(&registry().mutex);
+    Series &series = findSeries(name, help, "gauge", labels);
+    if (!series.gauge) {
+        series.gauge.reset(new Gauge);
+    }
+    return *series.gauge;
+}
+
+Metrics::Histogram &Metrics::histogram(const char *name, const char *help, const QString &labels)
+{
+    QMutexLocker locker(&registry().mutex);
+    Series &series = findSeries(name, help, "histogram", labels);
+    if (!series.histogram) {
+        series.histogram.reset(new Histogram);
+    }
+    return *series.histogram;
+}
+
+void Metrics::callbackGauge(const char *name, const char *help, std::function<double()> read, const QString &labels)
+{
+    QMutexLocker locker(&registry().mutex);
+    findSeries(name, help, "gauge", labels).read = std::move(read);
+}
+
+void Metrics::callbackCounter(const char *name, const char *help, std::function<quint64()> read, const QString &labels)
+{
+    QMutexLocker locker(&registry().mutex);
+    findSeries(name, help, "counter", labels).read = [read]() { return double(read()); };
+}
+
+QByteArray Metrics::renderPrometheus()
+{
+#ifdef Q_OS_LINUX
+    static const bool processMetrics = [] {
+        callbackGauge("pidashboard_process_resident_bytes", "Resident set size of the process.", residentBytes);
+        return true;
+    }();
+    Q_UNUSED(processMetrics)
+#endif
+
+    QByteArray out;
+    QMutexLocker locker(&registry().mutex);
+
+    for (const auto &familyEntry : registry().families) {
+        const QByteArray &name = familyEntry.first;
+        const Family &family = familyEntry.second;
+        out += "# HELP " + name + " " + family.help + "\n";
+        out += "# TYPE " + name + " " + family.type + "\n";
+
+        for (const auto &seriesEntry : family.series) {
+            const QString &labels = seriesEntry.first;
+            const Series &series = seriesEntry.second;
+
+            if (series.counter) {
+                out += seriesName(name, labels) + " " + QByteArray::number(series.counter->get()) + "\n";
+            } else if (series.gauge) {
+                out += seriesName(name, labels) + " " + QByteArray::number(series.gauge->get(), 'g', 12) + "\n";
+            } else if (series.read) {
+                out += seriesName(name, labels) + " " + QByteArray::number(series.read(), 'g', 12) + "\n";
+            } else if (series.histogram) {
+                const Histogram &histogram = *series.histogram;
+                quint64 cumulative = 0;
+                for (int i = 0; i < Histogram::BUCKET_COUNT; ++i) {
+                    cumulative += histogram.buckets[i].load(std::memory_order_relaxed);
+                    QString le = QString("le=\"%1\"").arg(Histogram::BOUNDS_NS[i] / 1e9);
+                    out += seriesName(name + "_bucket", labels, le) + " " + QByteArray::number(cumulative) + "\n";
+                }
+                cumulative += histogram.buckets[Histogram::BUCKET_COUNT].load(std::memory_order_relaxed);
+                out += seriesName(name + "_bucket", labels, "le=\"+Inf\"") + " " + QByteArray::number(cumulative) + "\n";
+                out += seriesName(name + "_sum", labels) + " "
+                       + QByteArray::number(histogram.sumNs.load(std::memory_order_relaxed) / 1e9, 'g', 12) + "\n";
+                out += seriesName(name + "_count", labels) + " " + QByteArray::number(cumulative) + "\n";
+            }
+        }
+    }
+    return out;
+}
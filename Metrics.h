@@ -0,0 +1,82 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QString>
+#include <atomic>
+#include <functional>
+
+// Process-wide registry of counters, gauges and latency histograms. Looking
+// up a series takes a lock, so hot paths keep the returned reference;
+// updating a series afterwards is a relaxed atomic operation. Labels are
+// given pre-rendered, e.g. feed="news".
+class Metrics
+{
+public:
+    class Counter
+    {
+    public:
+        void add(quint64 amount = 1) { value.fetch_add(amount, std::memory_order_relaxed); }
+        quint64 get() const { return value.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<quint64> value{0};
+    };
+
+    class Gauge
+    {
+    public:
+        void set(double newValue) { value.store(newValue, std::memory_order_relaxed); }
+        double get() const { return value.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<double> value{0};
+    };
+
+    // Durations with fixed buckets from 100 us to 10 s
+    class Histogram
+    {
+    public:
+        static const int BUCKET_COUNT = 16;
+        static const qint64 BOUNDS_NS[BUCKET_COUNT];
+
+        void observeNs(qint64 ns);
+
+    private:
+        friend class Metrics;
+        std::atomic<quint64> buckets[BUCKET_COUNT + 1] = {};
+        std::atomic<quint64> count{0};
+        std::atomic<quint64> sumNs{0};
+    };
+
+    // Observes the lifetime of the scope into a histogram
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer(Histogram &histogram) : histogram(histogram) { timer.start(); }
+        ~ScopedTimer() { histogram.observeNs(timer.nsecsElapsed()); }
+
+    private:
+        Histogram &histogram;
+        QElapsedTimer timer;
+    };
+
+    static Counter &counter(const char *name, const char *help, const QString &labels = QString());
+    static Gauge &gauge(const char *name, const char *help, const QString &labels = QString());
+    static Histogram &histogram(const char *name, const char *help, const QString &labels = QString());
+
+    // Registers a gauge whose value is read when metrics are rendered
+    static void callbackGauge(const char *name, const char *help, std::function<double()> read,
+                              const QString &labels = QString());
+
+    // Registers a counter kept elsewhere, read when metrics are rendered;
+    // the value must never decrease
+    static void callbackCounter(const char *name, const char *help, std::function<quint64()> read,
+                                const QString &labels = QString());
+
+    // All series in the Prometheus text exposition format
+    static QByteArray renderPrometheus();
+};
+
+#endif // METRICS_H
@@ -0,0 +1,81 @@
+#include "MetricsServer.h"
+#include "Metrics.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QTcpSocket>
+
+namespace {
+// Scrapers send a small GET; anything bigger is not a metrics request
+static const int MAX_REQUEST_BYTES = 8192;
+}
+
+MetricsServer::MetricsServer(QObject *parent)
+    : QObject(parent)
+{
+    connect(&server, &QTcpServer::newConnection, this, &MetricsServer::onNewConnection);
+    connect(&dumpTimer, &QTimer::timeout, this, &MetricsServer::writeDump);
+    dumpTimer.setTimerType(Qt::VeryCoarseTimer);
+}
+
+bool MetricsServer::listen(quint16 port)
+{
+    if (port == 0) {
+        return false;
+    }
+
+    if (!server.listen(QHostAddress::LocalHost, port)) {
+        qInfo() << "Metrics endpoint unavailable:" << server.errorString();
+        return false;
+    }
+    return true;
+}
+
+void MetricsServer::startFileDump(const QString &path, int intervalSeconds)
+{
+    dumpPath = path;
+    if (dumpPath.isEmpty() || intervalSeconds <= 0) {
+        dumpTimer.stop();
+        return;
+    }
+
+    QDir().mkpath(QFileInfo(dumpPath).absolutePath());
+    dumpTimer.start(intervalSeconds * 1000);
+}
+
+void MetricsServer::onNewConnection()
+{
+    while (QTcpSocket *socket = server.nextPendingConnection()) {
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QTcpSocket::readyRead, socket, [socket]() {
+            // Answer once the request headers are complete, whatever the path
+            if (socket->bytesAvailable() > MAX_REQUEST_BYTES) {
+                socket->abort();
+                return;
+            }
+            if (!socket->peek(MAX_REQUEST_BYTES).contains("\r\n\r\n")) {
+                return;
+            }
+            socket->readAll();
+
+            const QByteArray body = Metrics::renderPrometheus();
+            socket->write("HTTP/1.0 200 OK\r\n"
+                          "Content-Type: text/plain; version=0.0.4\r\n"
+                          "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+                          "Connection: close\r\n\r\n");
+            socket->write(body);
+            socket->disconnectFromHost();
+        });
+    }
+}
+
+void MetricsServer::writeDump()
+{
+    QSaveFile file(dumpPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    file.write(Metrics::renderPrometheus());
+    file.commit();
+}
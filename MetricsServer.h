@@ -0,0 +1,34 @@
+#ifndef METRICSSERVER_H
+#define METRICSSERVER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTimer>
+
+// Exposes Metrics as Prometheus text over HTTP on localhost only and
+// periodically writes the same text to a local file.
+class MetricsServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MetricsServer(QObject *parent = nullptr);
+
+    // Listens on 127.0.0.1; a port of 0 disables the endpoint
+    bool listen(quint16 port);
+
+    // Rewrites the file every interval; an empty path disables the dump
+    void startFileDump(const QString &path, int intervalSeconds);
+
+private slots:
+    void onNewConnection();
+
+private:
+    QTcpServer server;
+    QTimer dumpTimer;
+    QString dumpPath;
+
+    void writeDump();
+};
+
+#endif // METRICSSERVER_H
@@ -0,0 +1,130 @@
+#include "NetworkArchive.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+
+namespace {
+static const quint32 ARCHIVE_MAGIC = 0x50444e41; // "PDNA"
+static const quint32 ARCHIVE_VERSION = 3;
+
+bool isCookie(const QByteArray &header)
+{
+    return header.compare("Set-Cookie", Qt::CaseInsensitive) == 0
+           || header.compare("Set-Cookie2", Qt::CaseInsensitive) == 0;
+}
+}
+
+bool NetworkArchive::load(const QString &path)
+{
+    QFile input(path);
+    if (!input.open(QIODevice::ReadOnly)) {
+        qInfo() << "Cannot open network archive" << path << input.errorString();
+        return false;
+    }
+
+    QDataStream in(&input);
+    in.setVersion(QDataStream::Qt_5_15);
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if (in.status() != QDataStream::Ok || magic != ARCHIVE_MAGIC || version != ARCHIVE_VERSION) {
+        qInfo() << "Not a network archive:" << path;
+        return false;
+    }
+
+    while (!in.atEnd()) {
+        Entry entry;
+        qint32 error = 0;
+        QByteArray compressed;
+        in >> entry.urlHash >> entry.conditional >> entry.status >> entry.reason >> entry.headers
+           >> error >> entry.errorString >> compressed >> entry.firstByteMs >> entry.totalMs
+           >> entry.truncated;
+        if (in.status() != QDataStream::Ok) {
+            qInfo() << "Network archive truncated after" << entries.size() << "responses";
+            break;
+        }
+        entry.error = QNetworkReply::NetworkError(error);
+        entry.body = compressed.isEmpty() ? QByteArray() : qUncompress(compressed);
+
+        index[keyFor(entry.urlHash, entry.conditional)].append(entries.size());
+        entries.append(entry);
+    }
+    return true;
+}
+
+bool NetworkArchive::openForAppend(const QString &path)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    file.setFileName(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qInfo() << "Cannot write network archive" << path << file.errorString();
+        return false;
+    }
+
+    if (file.size() == 0) {
+        QDataStream out(&file);
+        out.setVersion(QDataStream::Qt_5_15);
+        out << ARCHIVE_MAGIC << ARCHIVE_VERSION;
+        file.flush();
+    }
+    return true;
+}
+
+void NetworkArchive::append(const Entry &entry)
+{
+    if (!file.isOpen()) {
+        return;
+    }
+
+    QList<QPair<QByteArray, QByteArray>> headers;
+    for (const auto &header : entry.headers) {
+        if (!isCookie(header.first)) {
+            headers.append(header);
+        }
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << entry.urlHash << entry.conditional << entry.status << entry.reason << headers
+        << qint32(entry.error) << entry.errorString
+        << (entry.body.isEmpty() ? QByteArray() : qCompress(entry.body))
+        << entry.firstByteMs << entry.totalMs << entry.truncated;
+    file.flush();
+}
+
+const NetworkArchive::Entry *NetworkArchive::next(const QUrl &url, bool conditional)
+{
+    // A conditional request falls back to a full response
+    const QByteArray urlHash = hashUrl(url);
+    QByteArray key = keyFor(urlHash, conditional);
+    auto it = index.constFind(key);
+    if (it == index.cend() && conditional) {
+        key = keyFor(urlHash, false);
+        it = index.constFind(key);
+    }
+    if (it == index.cend()) {
+        return nullptr;
+    }
+
+    int &position = positions[key];
+    const Entry *entry = &entries[it->at(position)];
+    position = (position + 1) % it->size();
+    return entry;
+}
+
+int NetworkArchive::size() const
+{
+    return entries.size();
+}
+
+QByteArray NetworkArchive::hashUrl(const QUrl &url)
+{
+    return QCryptographicHash::hash(url.toEncoded(), QCryptographicHash::Sha1);
+}
+
+QByteArray NetworkArchive::keyFor(const QByteArray &urlHash, bool conditional)
+{
+    return (conditional ? "c" : " ") + urlHash;
+}
@@ -0,0 +1,67 @@
+#ifndef NETWORKARCHIVE_H
+#define NETWORKARCHIVE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QNetworkReply>
+#include <QPair>
+#include <QString>
+#include <QUrl>
+#include <QVector>
+
+// Append-only file of recorded HTTP responses: status, headers, compressed
+// body and the time to the first byte and to the end of the transfer.
+// Responses are looked up by URL and by whether the request carried
+// validators, so a recorded 304 is only replayed to a conditional request.
+// URLs carry API keys, so only a hash of them is stored, and cookies set by
+// the server are left out. A response the client cancelled part way is kept
+// with the body received so far.
+// Several responses for one request are served in recorded order, then
+// again from the first.
+class NetworkArchive
+{
+public:
+    struct Entry {
+        QByteArray urlHash;
+        bool conditional = false;
+        int status = 0;
+        QByteArray reason;
+        QList<QPair<QByteArray, QByteArray>> headers;
+        QNetworkReply::NetworkError error = QNetworkReply::NoError;
+        QString errorString;
+        QByteArray body;
+        int firstByteMs = 0;
+        int totalMs = 0;
+        // The client cancelled the request after part of the body had arrived
+        bool truncated = false;
+    };
+
+    // Reads every complete entry, ignoring a truncated one at the end
+    bool load(const QString &path);
+
+    // Opens the file for appending, writing the header if it is new
+    bool openForAppend(const QString &path);
+
+    // Writes the entry and flushes it, so a crash loses at most one response
+    void append(const Entry &entry);
+
+    // Next response for the request, null if none was recorded
+    const Entry *next(const QUrl &url, bool conditional);
+
+    int size() const;
+
+    static QByteArray hashUrl(const QUrl &url);
+
+private:
+    QFile file;
+    QVector<Entry> entries;
+    // Indices into entries and the position of the next one to serve
+    QHash<QByteArray, QVector<int>> index;
+    QHash<QByteArray, int> positions;
+
+    static QByteArray keyFor(const QByteArray &urlHash, bool conditional);
+};
+
+#endif // NETWORKARCHIVE_H
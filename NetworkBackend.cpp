@@ -0,0 +1,249 @@
+#include "NetworkBackend.h"
+#include "Metrics.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <cstring>
+
+namespace {
+// Replayed bodies are handed over in pieces this often
+static const int CHUNK_INTERVAL_MS = 20;
+
+bool isConditional(const QNetworkRequest &request)
+{
+    return request.hasRawHeader("If-None-Match") || request.hasRawHeader("If-Modified-Since");
+}
+
+// Reply whose body is pushed in by a subclass and read out by the owner
+class BufferedReply : public QNetworkReply
+{
+public:
+    BufferedReply(QNetworkAccessManager::Operation op, const QNetworkRequest &request, QObject *parent)
+        : QNetworkReply(parent)
+    {
+        setRequest(request);
+        setUrl(request.url());
+        setOperation(op);
+        open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    }
+
+    qint64 bytesAvailable() const override
+    {
+        return buffer.size() + QNetworkReply::bytesAvailable();
+    }
+
+    bool isSequential() const override
+    {
+        return true;
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override
+    {
+        const int count = int(qMin<qint64>(maxSize, buffer.size()));
+        std::memcpy(data, buffer.constData(), size_t(count));
+        buffer.remove(0, count);
+        return count;
+    }
+
+    void respond(int status, const QByteArray &reason, const QList<QPair<QByteArray, QByteArray>> &headers)
+    {
+        if (status > 0) {
+            setAttribute(QNetworkRequest::HttpStatusCodeAttribute, status);
+            setAttribute(QNetworkRequest::HttpReasonPhraseAttribute, reason);
+        }
+        for (const auto &header : headers) {
+            setRawHeader(header.first, header.second);
+        }
+        emit metaDataChanged();
+    }
+
+    void deliver(const QByteArray &data)
+    {
+        if (data.isEmpty()) {
+            return;
+        }
+        buffer.append(data);
+        emit readyRead();
+    }
+
+    void complete(NetworkError code, const QString &errorString)
+    {
+        if (isFinished()) {
+            return;
+        }
+        if (code != NoError) {
+            setError(code, errorString);
+            emit errorOccurred(code);
+        }
+        setFinished(true);
+        emit finished();
+    }
+
+private:
+    QByteArray buffer;
+};
+
+// Passes a live reply through and archives it once it has finished
+class RecordingReply : public BufferedReply
+{
+public:
+    RecordingReply(QNetworkReply *live, NetworkArchive *archive, QObject *parent)
+        : BufferedReply(live->operation(), live->request(), parent),
+        live(live)
+    {
+        live->setParent(this);
+        timer.start();
+        entry.urlHash = NetworkArchive::hashUrl(live->request().url());
+        entry.conditional = isConditional(live->request());
+
+        connect(live, &QNetworkReply::metaDataChanged, this, [this]() {
+            entry.firstByteMs = int(timer.elapsed());
+            entry.status = this->live->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+            entry.reason = this->live->attribute(QNetworkRequest::HttpReasonPhraseAttribute).toByteArray();
+            entry.headers = this->live->rawHeaderPairs();
+            respond(entry.status, entry.reason, entry.headers);
+        });
+        connect(live, &QNetworkReply::readyRead, this, [this]() {
+            const QByteArray data = this->live->readAll();
+            entry.body += data;
+            deliver(data);
+        });
+        connect(live, &QNetworkReply::finished, this, [this, archive]() {
+            entry.totalMs = int(timer.elapsed());
+            entry.error = this->live->error();
+            entry.errorString = entry.error != NoError ? this->live->errorString() : QString();
+            deliver(this->live->readAll());
+
+            // A reply cut short once the reader had enough items is kept with
+            // the part that arrived; one aborted before any response says
+            // nothing about the server
+            const bool cancelled = entry.error == OperationCanceledError;
+            if (!cancelled || (entry.status != 0 && !entry.body.isEmpty())) {
+                // Replayed as a complete response; the reader stops at the
+                // same item limit before reaching the cut
+                NetworkArchive::Entry archived = entry;
+                if (cancelled) {
+                    archived.error = NoError;
+                    archived.errorString.clear();
+                    archived.truncated = true;
+                }
+                archive->append(archived);
+                static Metrics::Counter &recorded = Metrics::counter(
+                    "pidashboard_network_recorded_total", "Responses written to the network archive.");
+                recorded.add();
+            }
+            complete(entry.error, entry.errorString);
+        });
+    }
+
+    void abort() override
+    {
+        live->abort();
+    }
+
+private:
+    QNetworkReply *live;
+    NetworkArchive::Entry entry;
+    QElapsedTimer timer;
+};
+
+// Serves an archived response, or a 404 if there is none
+class ReplayReply : public BufferedReply
+{
+public:
+    ReplayReply(QNetworkAccessManager::Operation op, const QNetworkRequest &request,
+                const NetworkArchive::Entry *entry, const NetworkBackend::ReplayTiming &timing, QObject *parent)
+        : BufferedReply(op, request, parent),
+        entry(entry)
+    {
+        // The owner connects after createRequest returns, so even an
+        // instant response is delivered from the event loop
+        int latencyMs = 0;
+        int transferMs = 0;
+        if (timing.realTime && entry) {
+            latencyMs = timing.latencyMs >= 0 ? timing.latencyMs : entry->firstByteMs;
+            transferMs = timing.bandwidthKbit > 0
+                ? int(qint64(entry->body.size()) * 8 / timing.bandwidthKbit)
+                : qMax(0, entry->totalMs - entry->firstByteMs);
+        }
+        chunks = qMax(1, transferMs / CHUNK_INTERVAL_MS);
+
+        timer.setInterval(transferMs / chunks);
+        connect(&timer, &QTimer::timeout, this, [this]() { sendChunk(); });
+        QTimer::singleShot(latencyMs, this, [this]() { start(); });
+    }
+
+    void abort() override
+    {
+        timer.stop();
+        aborted = true;
+        complete(OperationCanceledError, "Operation canceled");
+    }
+
+private:
+    const NetworkArchive::Entry *entry;
+    QTimer timer;
+    int chunks;
+    int sent = 0;
+    bool aborted = false;
+
+    void start()
+    {
+        if (aborted) {
+            return;
+        }
+        if (!entry) {
+            respond(404, "Not Found", {});
+            complete(ContentNotFoundError, "Not in the network archive: " + url().toString(QUrl::RemoveQuery));
+            return;
+        }
+        respond(entry->status, entry->reason, entry->headers);
+        sendChunk();
+        if (!isFinished()) {
+            timer.start();
+        }
+    }
+
+    void sendChunk()
+    {
+        const int size = entry->body.size();
+        const int from = int(qint64(size) * sent / chunks);
+        const int to = int(qint64(size) * ++sent / chunks);
+        deliver(entry->body.mid(from, to - from));
+        if (sent == chunks) {
+            timer.stop();
+            complete(entry->error, entry->errorString);
+        }
+    }
+};
+}
+
+NetworkBackend::NetworkBackend(Mode mode, const QString &archivePath, const ReplayTiming &timing, QObject *parent)
+    : QNetworkAccessManager(parent),
+    mode(mode),
+    timing(timing)
+{
+    if (mode == Mode::RECORD) {
+        archive.openForAppend(archivePath);
+        qInfo() << "Recording network responses to" << archivePath;
+    } else {
+        archive.load(archivePath);
+        qInfo() << "Replaying" << archive.size() << "network responses from" << archivePath;
+    }
+}
+
+QNetworkReply *NetworkBackend::createRequest(Operation op, const QNetworkRequest &request, QIODevice *outgoingData)
+{
+    if (mode == Mode::RECORD) {
+        return new RecordingReply(QNetworkAccessManager::createRequest(op, request, outgoingData), &archive, this);
+    }
+
+    const NetworkArchive::Entry *entry = archive.next(request.url(), isConditional(request));
+    static Metrics::Counter &replayed = Metrics::counter("pidashboard_network_replayed_total",
+                                                         "Requests answered from the network archive.", "result=\"hit\"");
+    static Metrics::Counter &missing = Metrics::counter("pidashboard_network_replayed_total",
+                                                        "Requests answered from the network archive.", "result=\"miss\"");
+    (entry ? replayed : missing).add();
+    return new ReplayReply(op, request, entry, timing, this);
+}
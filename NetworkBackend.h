@@ -0,0 +1,41 @@
+#ifndef NETWORKBACKEND_H
+#define NETWORKBACKEND_H
+
+#include <QNetworkAccessManager>
+#include "NetworkArchive.h"
+
+// Network access manager that records every response to a NetworkArchive
+// or replays them from one without touching the network. Replayed
+// responses arrive with the recorded latency and transfer time, or with a
+// fixed latency and bandwidth, so timing experiments are repeatable.
+class NetworkBackend : public QNetworkAccessManager
+{
+    Q_OBJECT
+
+public:
+    enum class Mode {
+        RECORD,
+        REPLAY
+    };
+
+    struct ReplayTiming {
+        // False serves every response at once
+        bool realTime = true;
+        // Time to the first byte, -1 for the recorded one
+        int latencyMs = -1;
+        // Body transfer rate in kbit/s, 0 for the recorded transfer time
+        int bandwidthKbit = 0;
+    };
+
+    NetworkBackend(Mode mode, const QString &archivePath, const ReplayTiming &timing, QObject *parent = nullptr);
+
+protected:
+    QNetworkReply *createRequest(Operation op, const QNetworkRequest &request, QIODevice *outgoingData) override;
+
+private:
+    Mode mode;
+    ReplayTiming timing;
+    NetworkArchive archive;
+};
+
+#endif // NETWORKBACKEND_H
@@ -0,0 +1,144 @@
+#include "NetworkService.h"
+#include "EnvVars.h"
+#include "NetworkBackend.h"
+#include "Trace.h"
+#include <QCoreApplication>
+#include <QStandardPaths>
+#include <QUrl>
+#include <memory>
+#ifndef QT_NO_SSL
+#include <QSslConfiguration>
+#endif
+
+namespace {
+static const int DEFAULT_MAX_REQUESTS_PER_HOST = 2;
+static const int TRANSFER_TIMEOUT_MS = 60 * 1000;
+}
+
+NetworkService *NetworkService::instance()
+{
+    static NetworkService *service = new NetworkService(QCoreApplication::instance());
+    return service;
+}
+
+NetworkService::NetworkService(QObject *parent)
+    : QObject(parent),
+    networkManager(new QNetworkAccessManager(this)),
+    maxRequestsPerHost(DEFAULT_MAX_REQUESTS_PER_HOST)
+{
+#ifndef QT_NO_SSL
+    // Let new connections resume TLS sessions instead of full handshakes
+    QSslConfiguration ssl = QSslConfiguration::defaultConfiguration();
+    ssl.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+    ssl.setSslOption(QSsl::SslOptionDisableSessionTickets, false);
+    QSslConfiguration::setDefaultConfiguration(ssl);
+#endif
+}
+
+void NetworkService::get(const QNetworkRequest &request, QObject *context, StartedCallback onStarted)
+{
+    QNetworkRequest shared(request);
+    shared.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+    // Stalled transfers fail instead of holding a host slot forever
+    shared.setTransferTimeout(TRANSFER_TIMEOUT_MS);
+
+    const QString host = request.url().host();
+    pending[host].enqueue({shared, context, std::move(onStarted), Trace::isEnabled() ? Trace::now() : 0});
+    startNext(host);
+}
+
+void NetworkService::setMaxRequestsPerHost(int limit)
+{
+    maxRequestsPerHost = qMax(1, limit);
+
+    const QStringList hosts = pending.keys();
+    for (const QString &host : hosts) {
+        startNext(host);
+    }
+}
+
+void NetworkService::configure(const std::map<QString, QString> &envVars)
+{
+    const QString mode = envString(envVars, "NETWORK_MODE", "live");
+    if (mode != "record" && mode != "replay") {
+        return;
+    }
+
+    const QString archivePath = envString(envVars, "NETWORK_ARCHIVE",
+        QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/network.archive");
+    NetworkBackend::ReplayTiming timing;
+    timing.realTime = envInt(envVars, "NETWORK_REPLAY_TIMING", 1) != 0;
+    timing.latencyMs = envInt(envVars, "NETWORK_LATENCY_MS", -1);
+    timing.bandwidthKbit = qMax(0, envInt(envVars, "NETWORK_BANDWIDTH_KBIT", 0));
+
+    networkManager->deleteLater();
+    networkManager = new NetworkBackend(mode == "record" ? NetworkBackend::Mode::RECORD : NetworkBackend::Mode::REPLAY,
+                                        archivePath, timing, this);
+}
+
+void NetworkService::startNext(const QString &host)
+{
+    // Owners may queue or abort requests from their callbacks, so the queue
+    // is looked up again on every iteration
+    while (active.value(host) < maxRequestsPerHost) {
+        auto it = pending.find(host);
+        if (it == pending.end()) {
+            return;
+        }
+        if (it->isEmpty()) {
+            pending.erase(it);
+            return;
+        }
+
+        Pending next = it->dequeue();
+        if (!next.context) {
+            continue;
+        }
+
+        active[host]++;
+        QNetworkReply *reply = networkManager->get(next.request);
+
+        // Free the slot before the owner sees finished and possibly deletes the reply
+        connect(reply, &QNetworkReply::finished, this, [this, host]() {
+            active[host]--;
+            startNext(host);
+        });
+
+        if (Trace::isEnabled()) {
+            traceReply(reply, host, next.queuedNs);
+        }
+
+        next.onStarted(reply);
+    }
+}
+
+void NetworkService::traceReply(QNetworkReply *reply, const QString &host, qint64 queuedNs)
+{
+    // Requests overlap on the GUI thread, so each gets its own async track
+    const quint64 id = ++traceId;
+    const QByteArray detail = host.toUtf8();
+    const qint64 startNs = Trace::now();
+    auto firstByteNs = std::make_shared<qint64>(-1);
+
+    Trace::async("queued", "network", id, queuedNs, startNs, detail.constData());
+
+#ifndef QT_NO_SSL
+    // Covers DNS, TCP connect and the TLS handshake; reused connections skip it
+    connect(reply, &QNetworkReply::encrypted, this, [id, detail, startNs]() {
+        Trace::async("connect+tls", "network", id, startNs, Trace::now(), detail.constData());
+    });
+#endif
+    connect(reply, &QNetworkReply::metaDataChanged, this, [id, detail, startNs, firstByteNs]() {
+        if (*firstByteNs < 0) {
+            *firstByteNs = Trace::now();
+            Trace::async("waiting", "network", id, startNs, *firstByteNs, detail.constData());
+        }
+    });
+    connect(reply, &QNetworkReply::finished, this, [id, detail, startNs, firstByteNs]() {
+        const qint64 endNs = Trace::now();
+        if (*firstByteNs >= 0) {
+            Trace::async("transfer", "network", id, *firstByteNs, endNs, detail.constData());
+        }
+        Trace::async("request", "network", id, startNs, endNs, detail.constData());
+    });
+}
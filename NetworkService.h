@@ -0,0 +1,60 @@
+#ifndef NETWORKSERVICE_H
+#define NETWORKSERVICE_H
+
+#include <QObject>
+#include <QHash>
+#include <QPointer>
+#include <QQueue>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <functional>
+#include <map>
+
+// Process-wide network stack shared by all readers and downloaders. One
+// QNetworkAccessManager keeps connections and TLS sessions warm across the
+// whole refresh cycle, HTTP/2 is allowed, and requests to the same host are
+// limited to a fixed number running at once. Every request of the dashboard
+// goes through here, which makes it the place to record or replay traffic.
+class NetworkService : public QObject
+{
+    Q_OBJECT
+
+public:
+    using StartedCallback = std::function<void(QNetworkReply *)>;
+
+    static NetworkService *instance();
+
+    // Queues a GET and hands the reply to onStarted once a slot for its host
+    // is free. The caller owns the reply and must deleteLater() it when it
+    // has finished. Nothing is started if context is destroyed meanwhile.
+    void get(const QNetworkRequest &request, QObject *context, StartedCallback onStarted);
+
+    void setMaxRequestsPerHost(int limit);
+
+    // Records every response to, or replays them from, an archive instead of
+    // only using the live network (NETWORK_MODE=record|replay, see
+    // NetworkBackend). Call before the first request.
+    void configure(const std::map<QString, QString> &envVars);
+
+private:
+    struct Pending {
+        QNetworkRequest request;
+        QPointer<QObject> context;
+        StartedCallback onStarted;
+        qint64 queuedNs;
+    };
+
+    explicit NetworkService(QObject *parent = nullptr);
+
+    QNetworkAccessManager *networkManager;
+    QHash<QString, QQueue<Pending>> pending;
+    QHash<QString, int> active;
+    int maxRequestsPerHost;
+    quint64 traceId = 0;
+
+    void startNext(const QString &host);
+    void traceReply(QNetworkReply *reply, const QString &host, qint64 queuedNs);
+};
+
+#endif // NETWORKSERVICE_H
@@ -0,0 +1,210 @@
+#include "NewsAggregator.h"
+#include <QDateTime>
+#include <algorithm>
+#include <vector>
+
+namespace {
+quint64 hash64(const QString &text)
+{
+    return (quint64(qHash(text, 0)) << 32) | qHash(text, 0x9e3779b9U);
+}
+
+// Lower case letters and digits separated by single spaces, so punctuation
+// and spacing differences between sources do not defeat deduplication
+QString normalizedTitle(const QString &title)
+{
+    QString normalized;
+    normalized.reserve(title.size());
+    bool gap = false;
+    for (const QChar c : title) {
+        if (!c.isLetterOrNumber()) {
+            gap = true;
+            continue;
+        }
+        if (gap && !normalized.isEmpty()) {
+            normalized += QLatin1Char(' ');
+        }
+        normalized += c.toLower();
+        gap = false;
+    }
+    return normalized;
+}
+
+// RSS uses RFC 2822 dates, Atom uses ISO 8601; unknown dates sort last
+qint64 parsePublished(const QString &date)
+{
+    const QString trimmed = date.trimmed();
+    QDateTime parsed = QDateTime::fromString(trimmed, Qt::RFC2822Date);
+    if (!parsed.isValid()) {
+        parsed = QDateTime::fromString(trimmed, Qt::ISODate);
+    }
+    return parsed.isValid() ? parsed.toSecsSinceEpoch() : 0;
+}
+}
+
+NewsAggregator::NewsAggregator(int slotCount)
+    : slotCount(slotCount),
+    slotKeys(slotCount, 0),
+    slotTitles(slotCount)
+{
+}
+
+QVector<int> NewsAggregator::update(int source, const NewsFeed &feed)
+{
+    if (source >= sourceKeys.size()) {
+        sourceKeys.resize(source + 1);
+    }
+
+    // Reference the new items before releasing the old ones, so records the
+    // source still carries are neither dropped nor rebuilt
+    QVector<quint64> keys;
+    keys.reserve(int(feed.items.size()));
+    for (const NewsItem &item : feed.items) {
+        const quint64 key = keyFor(item, &keys);
+        if (key == 0 || keys.contains(key)) {
+            continue;
+        }
+        records[key].references++;
+        keys.append(key);
+    }
+    for (quint64 key : qAsConst(sourceKeys[source])) {
+        release(key);
+    }
+    sourceKeys[source] = keys;
+
+    // At most sources x items per source candidates, newest first
+    std::vector<quint64> candidates;
+    candidates.reserve(records.size());
+    for (auto it = records.cbegin(); it != records.cend(); ++it) {
+        candidates.push_back(it.key());
+    }
+    const int count = qMin(slotCount, int(candidates.size()));
+    std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(),
+                      [this](quint64 a, quint64 b) {
+        const Record &first = *records.constFind(a);
+        const Record &second = *records.constFind(b);
+        if (first.published != second.published) {
+            return first.published > second.published;
+        }
+        return first.sequence < second.sequence;
+    });
+
+    QVector<int> changed;
+    for (int slot = 0; slot < slotCount; ++slot) {
+        const quint64 key = slot < count ? candidates[slot] : 0;
+        const QString &title = key ? records.constFind(key)->item.title : QString();
+        if (slotKeys[slot] != key || slotTitles[slot] != title) {
+            slotKeys[slot] = key;
+            slotTitles[slot] = title;
+            changed.append(slot);
+        }
+    }
+    return changed;
+}
+
+const NewsItem &NewsAggregator::headline(int slot) const
+{
+    static const NewsItem empty;
+    if (slot < 0 || slot >= slotCount || slotKeys[slot] == 0) {
+        return empty;
+    }
+    return records.constFind(slotKeys[slot])->item;
+}
+
+std::shared_ptr<const NewsFeed> NewsAggregator::headlines() const
+{
+    auto feed = std::make_shared<NewsFeed>();
+    for (int slot = 0; slot < slotCount && slotKeys[slot] != 0; ++slot) {
+        feed->items.push_back(headline(slot));
+    }
+    return feed;
+}
+
+quint64 NewsAggregator::keyFor(const NewsItem &item, QVector<quint64> *keys)
+{
+    const QString normalized = normalizedTitle(item.title);
+    const quint64 key = normalized.isEmpty() ? 0 : hash64(normalized);
+
+    // A known GUID keeps its record even if the title was edited
+    const quint64 guidKey = item.guid.isEmpty() ? 0 : hash64(item.guid);
+    if (guidKey) {
+        auto known = guidIndex.find(guidKey);
+        if (known != guidIndex.end()) {
+            const quint64 knownKey = known.value();
+            auto record = records.find(knownKey);
+            if (record != records.end()) {
+                if (key == knownKey) {
+                    record->item.title = item.title;
+                }
+                if (key == 0 || key == knownKey) {
+                    return knownKey;
+                }
+                // The record moves to the edited title, so a source carrying
+                // the new title matches it; if one already did, the two
+                // records merge and the new title is already shown
+                const bool merged = records.contains(key);
+                rekey(knownKey, key, keys);
+                if (!merged) {
+                    records[key].item.title = item.title;
+                }
+                return key;
+            }
+        }
+    }
+
+    if (key == 0) {
+        return 0;
+    }
+
+    // Only stories not seen in any source become new records
+    if (!records.contains(key)) {
+        Record record;
+        record.item = item;
+        record.published = parsePublished(item.pubDate);
+        record.guidKey = guidKey;
+        record.sequence = nextSequence++;
+        records.insert(key, record);
+    }
+    if (guidKey) {
+        guidIndex.insert(guidKey, key);
+    }
+    return key;
+}
+
+void NewsAggregator::rekey(quint64 from, quint64 to, QVector<quint64> *keys)
+{
+    const Record record = records.take(from);
+    auto existing = records.find(to);
+    if (existing == records.end()) {
+        records.insert(to, record);
+    } else {
+        existing->references += record.references;
+        if (existing->guidKey == 0) {
+            existing->guidKey = record.guidKey;
+        }
+    }
+    for (QVector<quint64> &sourceKeyList : sourceKeys) {
+        std::replace(sourceKeyList.begin(), sourceKeyList.end(), from, to);
+    }
+    std::replace(keys->begin(), keys->end(), from, to);
+    std::replace(slotKeys.begin(), slotKeys.end(), from, to);
+    for (auto it = guidIndex.begin(); it != guidIndex.end(); ++it) {
+        if (it.value() == from) {
+            it.value() = to;
+        }
+    }
+}
+
+void NewsAggregator::release(quint64 key)
+{
+    auto record = records.find(key);
+    if (record == records.end() || --record->references > 0) {
+        return;
+    }
+
+    auto guid = guidIndex.find(record->guidKey);
+    if (guid != guidIndex.end() && guid.value() == key) {
+        guidIndex.erase(guid);
+    }
+    records.erase(record);
+}
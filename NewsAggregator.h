@@ -0,0 +1,55 @@
+#ifndef NEWSAGGREGATOR_H
+#define NEWSAGGREGATOR_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include <memory>
+#include "FeedParser.h"
+
+// Merges the headlines of several news sources into a fixed number of slots,
+// newest first. Items are deduplicated by GUID and by normalized title, so a
+// story carried by two sources takes one slot. Only items not seen before
+// become new records; known ones are matched by hash and reused.
+class NewsAggregator
+{
+public:
+    explicit NewsAggregator(int slotCount);
+
+    // Replaces the items of one source and returns the slots whose headline
+    // changed as a result
+    QVector<int> update(int source, const NewsFeed &feed);
+
+    // Headline shown in a slot, empty if the slot is unused
+    const NewsItem &headline(int slot) const;
+
+    // The current slots as a feed, e.g. for the state snapshot
+    std::shared_ptr<const NewsFeed> headlines() const;
+
+private:
+    struct Record {
+        NewsItem item;
+        qint64 published = 0;
+        quint64 guidKey = 0;
+        int references = 0;
+        // Position among all items seen, breaks ties between equal dates
+        quint64 sequence = 0;
+    };
+
+    int slotCount;
+    quint64 nextSequence = 0;
+    QHash<quint64, Record> records;
+    QHash<quint64, quint64> guidIndex;
+    QVector<QVector<quint64>> sourceKeys;
+    QVector<quint64> slotKeys;
+    QVector<QString> slotTitles;
+
+    // Record key for the item; keys are the ones the update collected so far
+    quint64 keyFor(const NewsItem &item, QVector<quint64> *keys);
+    // Moves a record to a new key, e.g. after its title was edited, merging
+    // it into the record already there
+    void rekey(quint64 from, quint64 to, QVector<quint64> *keys);
+    void release(quint64 key);
+};
+
+#endif // NEWSAGGREGATOR_H
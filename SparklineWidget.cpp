@@ -0,0 +1,190 @@
+#include "SparklineWidget.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include <QPaintEvent>
+#include <QPainter>
+
+namespace {
+static const qint64 DAY_SECONDS = 24 * 60 * 60;
+static const qint64 WEEK_SECONDS = 7 * DAY_SECONDS;
+static const int HEIGHT = 40;
+static const int MARGIN = 3;
+// Added around the plotted range so small changes do not force a full redraw
+static const int RANGE_PADDING = 100;
+static const int MIN_RANGE = 400;
+// Readings further apart are not joined, e.g. after the dashboard was off
+static const qint64 MAX_GAP_SECONDS = 3 * 60 * 60;
+}
+
+SparklineWidget::SparklineWidget(QWidget *parent)
+    : QWidget(parent),
+    span(DAY_SECONDS)
+{
+    setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Fixed);
+}
+
+void SparklineWidget::setHistory(const TemperatureHistory *history, TemperatureHistory::Kind kind)
+{
+    this->history = history;
+    this->kind = kind;
+    renderAll();
+    update();
+}
+
+void SparklineWidget::appended()
+{
+    // The newest record of our kind, normally the last or the one before it
+    const quint32 count = history ? history->size() : 0;
+    quint32 index = count;
+    while (index > 0 && history->at(index - 1).kind != kind) {
+        --index;
+    }
+    if (index == 0) {
+        return;
+    }
+    const TemperatureHistory::Record &record = history->at(index - 1);
+
+    const double plotWidth = width() - 2 * MARGIN;
+    const int shift = int((record.time - endTime) * plotWidth / span);
+    if (!cacheValid || record.time < endTime || shift >= plotWidth
+        || record.centiDegrees < low || record.centiDegrees > high) {
+        renderAll();
+        update();
+        return;
+    }
+
+    static Metrics::Counter &segments = Metrics::counter("pidashboard_sparkline_segment_renders_total",
+                                                         "Readings added to the sparkline by drawing one segment.");
+    segments.add();
+    Trace::Span trace("SparklineWidget::appended", "paint");
+
+    QRect dirty;
+    if (shift > 0) {
+        // Move the line left by the elapsed time and clear the strip it exposes
+        cache.scroll(-shift, 0, cache.rect());
+        endTime += shift * span / plotWidth;
+        lastPoint.rx() -= shift;
+        dirty = rect();
+    }
+
+    QPainter painter(&cache);
+    if (shift > 0) {
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.fillRect(cache.width() - shift, 0, shift, cache.height(), Qt::transparent);
+        painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+    }
+    const bool hadPoint = hasLastPoint;
+    const QPointF from = lastPoint;
+    drawPoint(painter, record);
+    dirty |= QRectF(hadPoint ? from : lastPoint, lastPoint).normalized().toAlignedRect()
+             .adjusted(-MARGIN, -MARGIN, MARGIN, MARGIN);
+    update(dirty);
+}
+
+QSize SparklineWidget::sizeHint() const
+{
+    return QSize(200, HEIGHT);
+}
+
+void SparklineWidget::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(this);
+    for (const QRect &rect : event->region()) {
+        painter.drawPixmap(rect, cache, rect);
+    }
+
+    painter.setPen(QColor(255, 255, 255, 160));
+    painter.setFont(QFont(font().family(), 8));
+    painter.drawText(rect().adjusted(MARGIN, 0, 0, 0), Qt::AlignLeft | Qt::AlignTop,
+                     span == DAY_SECONDS ? "24h" : "7d");
+}
+
+void SparklineWidget::resizeEvent(QResizeEvent *event)
+{
+    renderAll();
+    QWidget::resizeEvent(event);
+}
+
+void SparklineWidget::mousePressEvent(QMouseEvent *event)
+{
+    span = span == DAY_SECONDS ? WEEK_SECONDS : DAY_SECONDS;
+    renderAll();
+    update();
+    QWidget::mousePressEvent(event);
+}
+
+void SparklineWidget::renderAll()
+{
+    static Metrics::Counter &renders = Metrics::counter("pidashboard_sparkline_full_renders_total",
+                                                        "Complete redraws of the sparkline.");
+    renders.add();
+    Trace::Span trace("SparklineWidget::renderAll", "paint");
+
+    cache = QPixmap(size());
+    cache.fill(Qt::transparent);
+    cacheValid = !cache.isNull();
+    hasLastPoint = false;
+
+    // Records are in append order, so the span ends at the newest reading
+    // and starts at the first one within it
+    const quint32 count = history ? history->size() : 0;
+    quint32 first = count;
+    bool found = false;
+    for (quint32 i = count; i > 0; --i) {
+        const TemperatureHistory::Record &record = history->at(i - 1);
+        if (record.kind != kind) {
+            continue;
+        }
+        if (!found) {
+            endTime = record.time;
+            low = high = record.centiDegrees;
+            found = true;
+        } else if (record.time < endTime - span) {
+            break;
+        }
+        low = qMin(low, int(record.centiDegrees));
+        high = qMax(high, int(record.centiDegrees));
+        first = i - 1;
+    }
+    if (!found) {
+        return;
+    }
+
+    low -= RANGE_PADDING;
+    high += RANGE_PADDING;
+    if (high - low < MIN_RANGE) {
+        const int middle = (low + high) / 2;
+        low = middle - MIN_RANGE / 2;
+        high = middle + MIN_RANGE / 2;
+    }
+
+    QPainter painter(&cache);
+    for (quint32 i = first; i < count; ++i) {
+        const TemperatureHistory::Record &record = history->at(i);
+        if (record.kind == kind) {
+            drawPoint(painter, record);
+        }
+    }
+}
+
+QPointF SparklineWidget::pointFor(const TemperatureHistory::Record &record) const
+{
+    const double plotWidth = width() - 2 * MARGIN;
+    const double plotHeight = height() - 2 * MARGIN;
+    return QPointF(MARGIN + plotWidth - (endTime - record.time) * plotWidth / span,
+                   MARGIN + plotHeight - (record.centiDegrees - low) * plotHeight / (high - low));
+}
+
+void SparklineWidget::drawPoint(QPainter &painter, const TemperatureHistory::Record &record)
+{
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(QPen(Qt::white, 1.5, Qt::SolidLine, Qt::RoundCap));
+
+    // A reading after a gap starts a new piece of line
+    const QPointF point = pointFor(record);
+    const bool joined = hasLastPoint && qint64(record.time) - qint64(lastTime) <= MAX_GAP_SECONDS;
+    painter.drawLine(joined ? lastPoint : point, point);
+    lastPoint = point;
+    lastTime = record.time;
+    hasLastPoint = true;
+}
@@ -0,0 +1,55 @@
+#ifndef SPARKLINEWIDGET_H
+#define SPARKLINEWIDGET_H
+
+#include <QPainter>
+#include <QPixmap>
+#include <QWidget>
+#include "TemperatureHistory.h"
+
+// Temperature sparkline over the last 24 hours or 7 days; a tap switches
+// between the two. The line is drawn into a cached pixmap. A new reading
+// scrolls the cache left by the elapsed time and only draws the segment to
+// the new point; the whole line is redrawn only when the span changes or a
+// reading falls outside the cached range.
+class SparklineWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit SparklineWidget(QWidget *parent = nullptr);
+
+    // Plots the records of one kind; the history must outlive the widget
+    void setHistory(const TemperatureHistory *history, TemperatureHistory::Kind kind);
+
+    // Call after a record of the plotted kind was appended
+    void appended();
+
+    QSize sizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+
+private:
+    const TemperatureHistory *history = nullptr;
+    TemperatureHistory::Kind kind = TemperatureHistory::TEMPERATURE;
+    qint64 span;
+    QPixmap cache;
+    bool cacheValid = false;
+    // Time at the right edge of the plot and the range it covers
+    double endTime = 0;
+    int low = 0;
+    int high = 0;
+    // End of the line drawn so far, absent after a gap
+    QPointF lastPoint;
+    quint32 lastTime = 0;
+    bool hasLastPoint = false;
+
+    void renderAll();
+    QPointF pointFor(const TemperatureHistory::Record &record) const;
+    // Continues the line to the record and makes it the new end
+    void drawPoint(QPainter &painter, const TemperatureHistory::Record &record);
+};
+
+#endif // SPARKLINEWIDGET_H
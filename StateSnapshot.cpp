@@ -0,0 +1,264 @@
+#include "StateSnapshot.h"
+#include "FeedFetcher.h"
+#include "Trace.h"
+#include <QBuffer>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace {
+static const quint32 SNAPSHOT_MAGIC = 0x50445353; // "PDSS"
+static const quint32 SNAPSHOT_VERSION = 3;
+static const int SAVE_DELAY_MS = 2000;
+
+// Most items a saved feed can hold; the news is the merged headlines
+qint64 maxSavedItems(XmlType type)
+{
+    switch (type) {
+    case XmlType::NEWS:
+        return FeedFetcher::NEWS_MAX_ITEMS;
+    case XmlType::FORECAST:
+        return Forecast::MAX_DAYS;
+    default:
+        return 1;
+    }
+}
+}
+
+// Each feed is a presence flag followed by its typed fields
+void StateSnapshot::writeResult(QDataStream &out, const FeedResult &result)
+{
+    if (result.news) {
+        out << quint8(1) << quint32(result.news->items.size());
+        for (const NewsItem &item : result.news->items) {
+            out << item.title << item.link << item.description << item.pubDate << item.guid;
+        }
+    } else if (result.weather) {
+        out << quint8(1) << result.weather->temperature << result.weather->feelsLike << result.weather->weather;
+    } else if (result.forecast) {
+        out << quint8(1) << qint32(result.forecast->count);
+        for (int i = 0; i < result.forecast->count; ++i) {
+            const ForecastItem &day = result.forecast->days[i];
+            out << day.date << day.maxTemp << day.minTemp << day.rainChance << day.icon;
+        }
+    } else {
+        out << quint8(0);
+    }
+}
+
+bool StateSnapshot::readResult(QDataStream &in, XmlType type, qint64 maxItems, FeedResult *result)
+{
+    quint8 present = 0;
+    in >> present;
+    if (!present) {
+        *result = FeedResult();
+        return in.status() == QDataStream::Ok;
+    }
+
+    switch (type) {
+    case XmlType::NEWS: {
+        auto news = std::make_shared<NewsFeed>();
+        quint32 count = 0;
+        in >> count;
+        if (in.status() != QDataStream::Ok || count > maxItems) {
+            return false;
+        }
+        news->items.resize(count);
+        for (NewsItem &item : news->items) {
+            in >> item.title >> item.link >> item.description >> item.pubDate >> item.guid;
+        }
+        result->news = news;
+        break;
+    }
+    case XmlType::WEATHER: {
+        auto weather = std::make_shared<CurrentWeather>();
+        in >> weather->temperature >> weather->feelsLike >> weather->weather;
+        result->weather = weather;
+        break;
+    }
+    case XmlType::FORECAST: {
+        auto forecast = std::make_shared<Forecast>();
+        qint32 count = 0;
+        in >> count;
+        if (count < 0 || count > Forecast::MAX_DAYS) {
+            return false;
+        }
+        forecast->count = count;
+        for (int i = 0; i < count; ++i) {
+            ForecastItem &day = forecast->days[i];
+            in >> day.date >> day.maxTemp >> day.minTemp >> day.rainChance >> day.icon;
+        }
+        result->forecast = forecast;
+        break;
+    }
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+StateSnapshot::StateSnapshot(const QString &snapshotPath, QObject *parent)
+    : QObject(parent),
+    path(snapshotPath)
+{
+    if (path.isEmpty()) {
+        path = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/state.snapshot";
+    }
+
+    saveTimer.setSingleShot(true);
+    saveTimer.setInterval(SAVE_DELAY_MS);
+    connect(&saveTimer, &QTimer::timeout, this, &StateSnapshot::save);
+}
+
+StateSnapshot::~StateSnapshot()
+{
+    if (dirty) {
+        save();
+    }
+}
+
+bool StateSnapshot::load(qint64 maxAgeSeconds)
+{
+    Trace::Span span("load", "snapshot");
+    QElapsedTimer timer;
+    timer.start();
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly) || file.size() == 0) {
+        return false;
+    }
+
+    // Decode straight from the page cache instead of reading into a buffer
+    uchar *mapped = file.map(0, file.size());
+    if (!mapped) {
+        return false;
+    }
+    const QByteArray data = QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), int(file.size()));
+    QBuffer buffer;
+    buffer.setData(data);
+    buffer.open(QIODevice::ReadOnly);
+    QDataStream in(&buffer);
+    in.setVersion(QDataStream::Qt_5_15);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint64 savedAt = 0;
+    in >> magic >> version >> savedAt;
+    if (in.status() != QDataStream::Ok || magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION) {
+        return false;
+    }
+    if (QDateTime::currentSecsSinceEpoch() - savedAt > maxAgeSeconds) {
+        qInfo() << "Snapshot too old, starting blank";
+        return false;
+    }
+
+    FeedResult loadedFeeds[FEED_COUNT];
+    for (int i = 0; i < FEED_COUNT; ++i) {
+        if (!readResult(in, XmlType(i), maxSavedItems(XmlType(i)), &loadedFeeds[i])) {
+            return false;
+        }
+    }
+
+    Icon loadedIcons[ICON_SLOTS];
+    for (Icon &icon : loadedIcons) {
+        qint32 width = 0;
+        qint32 height = 0;
+        in >> icon.url >> icon.size >> width >> height;
+        if (in.status() != QDataStream::Ok || width < 0 || height < 0) {
+            return false;
+        }
+
+        // Raw premultiplied pixels, copied once out of the mapping
+        const qint64 bytes = qint64(width) * height * 4;
+        const qint64 offset = buffer.pos();
+        if (bytes == 0) {
+            continue;
+        }
+        if (offset + bytes > data.size()) {
+            return false;
+        }
+        icon.image = QImage(mapped + offset, width, height, width * 4, QImage::Format_ARGB32_Premultiplied).copy();
+        in.skipRawData(int(bytes));
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        return false;
+    }
+
+    for (int i = 0; i < FEED_COUNT; ++i) {
+        feeds[i] = loadedFeeds[i];
+    }
+    for (int i = 0; i < ICON_SLOTS; ++i) {
+        icons[i] = loadedIcons[i];
+    }
+
+    qInfo() << "Snapshot loaded in" << timer.nsecsElapsed() / 1000 << "us";
+    return true;
+}
+
+FeedResult StateSnapshot::result(XmlType type) const
+{
+    return feeds[type];
+}
+
+StateSnapshot::Icon StateSnapshot::icon(int slot) const
+{
+    return slot >= 0 && slot < ICON_SLOTS ? icons[slot] : Icon();
+}
+
+void StateSnapshot::setResult(XmlType type, const FeedResult &result)
+{
+    feeds[type] = result;
+    scheduleSave();
+}
+
+void StateSnapshot::setIcon(int slot, const QString &url, const QSize &size, const QImage &image)
+{
+    if (slot < 0 || slot >= ICON_SLOTS || image.isNull()
+        || (icons[slot].url == url && icons[slot].size == size)) {
+        return;
+    }
+    icons[slot] = {url, size, image.convertToFormat(QImage::Format_ARGB32_Premultiplied)};
+    scheduleSave();
+}
+
+bool StateSnapshot::save()
+{
+    Trace::Span span("save", "snapshot");
+    saveTimer.stop();
+    dirty = false;
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << SNAPSHOT_MAGIC << SNAPSHOT_VERSION << QDateTime::currentSecsSinceEpoch();
+
+    for (const FeedResult &feed : feeds) {
+        writeResult(out, feed);
+    }
+
+    for (const Icon &icon : icons) {
+        out << icon.url << icon.size << qint32(icon.image.width()) << qint32(icon.image.height());
+        for (int y = 0; y < icon.image.height(); ++y) {
+            out.writeRawData(reinterpret_cast<const char *>(icon.image.constScanLine(y)), icon.image.width() * 4);
+        }
+    }
+
+    // Readers see either the previous snapshot or this one, never a mix
+    return file.commit();
+}
+
+void StateSnapshot::scheduleSave()
+{
+    dirty = true;
+    saveTimer.start();
+}
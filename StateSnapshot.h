@@ -0,0 +1,61 @@
+#ifndef STATESNAPSHOT_H
+#define STATESNAPSHOT_H
+
+#include <QObject>
+#include <QDataStream>
+#include <QImage>
+#include <QList>
+#include <QSize>
+#include <QTimer>
+#include "FeedParser.h"
+
+// Last known parsed feeds and forecast icons, persisted to one compact
+// binary file so the next start can render them before any network activity.
+// The file is memory-mapped for loading and replaced atomically when saved.
+class StateSnapshot : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int FEED_COUNT = 3;
+    static const int ICON_SLOTS = 3;
+
+    struct Icon {
+        QString url;
+        QSize size;
+        QImage image;
+    };
+
+    // Uses the platform cache location when no path is given
+    explicit StateSnapshot(const QString &path = QString(), QObject *parent = nullptr);
+    ~StateSnapshot();
+
+    // Reads the snapshot, ignoring it if older than maxAgeSeconds
+    bool load(qint64 maxAgeSeconds);
+
+    FeedResult result(XmlType type) const;
+    Icon icon(int slot) const;
+
+    // Updates are coalesced into one write shortly after the last change
+    void setResult(XmlType type, const FeedResult &result);
+    void setIcon(int slot, const QString &url, const QSize &size, const QImage &image);
+
+    // Writes pending changes now
+    bool save();
+
+    // Compact encoding of one feed, also used by the feed daemon protocol.
+    // readResult rejects documents with more than maxItems items.
+    static void writeResult(QDataStream &out, const FeedResult &result);
+    static bool readResult(QDataStream &in, XmlType type, qint64 maxItems, FeedResult *result);
+
+private:
+    QString path;
+    FeedResult feeds[FEED_COUNT];
+    Icon icons[ICON_SLOTS];
+    QTimer saveTimer;
+    bool dirty = false;
+
+    void scheduleSave();
+};
+
+#endif // STATESNAPSHOT_H
@@ -0,0 +1,171 @@
+#include "SystemStats.h"
+#include <QFile>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+// Scanners over the bytes read from a source; none of them allocates
+
+bool startsWith(const char *p, const char *end, const char *prefix)
+{
+    for (; *prefix; ++p, ++prefix) {
+        if (p == end || *p != *prefix) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const char *nextLine(const char *p, const char *end)
+{
+    while (p < end && *p != '\n') {
+        ++p;
+    }
+    return p < end ? p + 1 : end;
+}
+
+const char *findLine(const char *p, const char *end, const char *prefix)
+{
+    for (; p < end; p = nextLine(p, end)) {
+        if (startsWith(p, end, prefix)) {
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+// Skips blanks, then reads a decimal number and advances past it
+qint64 parseNumber(const char *&p, const char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        ++p;
+    }
+    const bool negative = p < end && *p == '-';
+    if (negative) {
+        ++p;
+    }
+    qint64 value = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        value = value * 10 + (*p - '0');
+        ++p;
+    }
+    return negative ? -value : value;
+}
+
+qint64 meminfoValue(const char *begin, const char *end, const char *key)
+{
+    const char *line = findLine(begin, end, key);
+    if (!line) {
+        return -1;
+    }
+    line += qstrlen(key);
+    return parseNumber(line, end);
+}
+
+double rate(quint64 current, quint64 previous, qint64 elapsedNs)
+{
+    // Counters restart when an interface goes away
+    return current >= previous ? (current - previous) * 1e9 / elapsedNs : 0;
+}
+}
+
+SystemStats::SystemStats(const SystemStatsSources &sources)
+{
+    const QString paths[SOURCE_COUNT] = {sources.stat, sources.meminfo, sources.netDev, sources.thermal};
+    for (int i = 0; i < SOURCE_COUNT; ++i) {
+        fds[i] = ::open(QFile::encodeName(paths[i]).constData(), O_RDONLY | O_CLOEXEC);
+    }
+}
+
+SystemStats::~SystemStats()
+{
+    for (int fd : fds) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+}
+
+int SystemStats::read(Source source)
+{
+    if (fds[source] < 0) {
+        return -1;
+    }
+    // Reading from offset 0 makes the kernel regenerate the file
+    const ssize_t length = ::pread(fds[source], buffer, BUFFER_SIZE, 0);
+    return length > 0 ? int(length) : -1;
+}
+
+SystemStats::Sample SystemStats::sample(qint64 nowNs)
+{
+    Sample result;
+    const qint64 elapsedNs = lastNs >= 0 ? nowNs - lastNs : 0;
+
+    // cpu  user nice system idle iowait irq softirq steal ...
+    int length = read(STAT);
+    const char *line = length > 0 ? findLine(buffer, buffer + length, "cpu ") : nullptr;
+    if (line) {
+        const char *p = line + 4;
+        quint64 fields[8] = {};
+        quint64 total = 0;
+        for (quint64 &field : fields) {
+            field = quint64(parseNumber(p, buffer + length));
+            total += field;
+        }
+        const quint64 busy = total - fields[3] - fields[4];
+        if (elapsedNs > 0 && total > lastTotal) {
+            result.cpuLoad = double(busy - qMin(busy, lastBusy)) / (total - lastTotal);
+        }
+        lastBusy = busy;
+        lastTotal = total;
+    }
+
+    length = read(MEMINFO);
+    if (length > 0) {
+        result.memTotalKb = meminfoValue(buffer, buffer + length, "MemTotal:");
+        result.memAvailableKb = meminfoValue(buffer, buffer + length, "MemAvailable:");
+    }
+
+    // Two header lines, then "  eth0: rx_bytes 7 more rx fields tx_bytes ..."
+    length = read(NET_DEV);
+    if (length > 0) {
+        const char *end = buffer + length;
+        quint64 rx = 0;
+        quint64 tx = 0;
+        for (const char *p = nextLine(nextLine(buffer, end), end); p < end; p = nextLine(p, end)) {
+            while (p < end && *p == ' ') {
+                ++p;
+            }
+            const char *name = p;
+            while (p < end && *p != ':' && *p != '\n') {
+                ++p;
+            }
+            if (p == end || *p != ':' || (p - name == 2 && startsWith(name, end, "lo"))) {
+                continue;
+            }
+            ++p;
+            rx += quint64(parseNumber(p, end));
+            for (int field = 0; field < 7; ++field) {
+                parseNumber(p, end);
+            }
+            tx += quint64(parseNumber(p, end));
+        }
+        if (elapsedNs > 0) {
+            result.rxBytesPerSecond = rate(rx, lastRx, elapsedNs);
+            result.txBytesPerSecond = rate(tx, lastTx, elapsedNs);
+        }
+        lastRx = rx;
+        lastTx = tx;
+    }
+
+    // Millidegrees Celsius
+    length = read(THERMAL);
+    if (length > 0) {
+        const char *p = buffer;
+        result.hasTemperature = true;
+        result.temperatureC = parseNumber(p, buffer + length) / 1000.0;
+    }
+
+    lastNs = nowNs;
+    return result;
+}
@@ -0,0 +1,65 @@
+#ifndef SYSTEMSTATS_H
+#define SYSTEMSTATS_H
+
+#include <QString>
+#include <QtGlobal>
+
+// Files SystemStats reads; tests and benchmarks point them at fixtures
+struct SystemStatsSources {
+    QString stat = "/proc/stat";
+    QString meminfo = "/proc/meminfo";
+    QString netDev = "/proc/net/dev";
+    QString thermal = "/sys/class/thermal/thermal_zone0/temp";
+};
+
+// Samples host health: SoC temperature, CPU load, memory and network
+// throughput. The files are opened once and re-read with pread into a fixed
+// buffer, and parsed in place, so a sample makes no allocation and costs a
+// few microseconds, almost all of it in the kernel generating the files.
+class SystemStats
+{
+public:
+    struct Sample {
+        // Busy share of all CPUs since the previous sample, -1 on the first
+        double cpuLoad = -1;
+        qint64 memTotalKb = -1;
+        qint64 memAvailableKb = -1;
+        // Summed over all interfaces but loopback, -1 on the first sample
+        double rxBytesPerSecond = -1;
+        double txBytesPerSecond = -1;
+        bool hasTemperature = false;
+        double temperatureC = 0;
+    };
+
+    explicit SystemStats(const SystemStatsSources &sources = SystemStatsSources());
+    ~SystemStats();
+
+    // Reads every source once; nowNs is a monotonic time used for the rates
+    Sample sample(qint64 nowNs);
+
+private:
+    Q_DISABLE_COPY(SystemStats)
+
+    enum Source {
+        STAT,
+        MEMINFO,
+        NET_DEV,
+        THERMAL,
+        SOURCE_COUNT
+    };
+
+    static const int BUFFER_SIZE = 16384;
+
+    int fds[SOURCE_COUNT];
+    char buffer[BUFFER_SIZE];
+    qint64 lastNs = -1;
+    quint64 lastBusy = 0;
+    quint64 lastTotal = 0;
+    quint64 lastRx = 0;
+    quint64 lastTx = 0;
+
+    // Number of bytes read into buffer, -1 if the source is unavailable
+    int read(Source source);
+};
+
+#endif // SYSTEMSTATS_H
@@ -0,0 +1,158 @@
+#include "TemperatureHistory.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <cstring>
+
+namespace {
+static const quint32 HISTORY_MAGIC = 0x50445448; // "PDTH"
+static const quint32 HISTORY_VERSION = 1;
+// Forecast samples are compared against this many newest records
+static const quint32 FORECAST_LOOKBACK = 64;
+}
+
+TemperatureHistory::TemperatureHistory(const QString &path)
+    : file(path.isEmpty()
+           ? QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/temperature.history"
+           : path)
+{
+}
+
+TemperatureHistory::~TemperatureHistory()
+{
+    if (header) {
+        file.unmap(reinterpret_cast<uchar *>(header));
+    }
+}
+
+bool TemperatureHistory::open(Unit unit)
+{
+    const qint64 size = qint64(sizeof(Header)) + qint64(CAPACITY) * sizeof(Record);
+    QDir().mkpath(QFileInfo(file.fileName()).absolutePath());
+    if (!file.open(QIODevice::ReadWrite) || (file.size() != size && !file.resize(size))) {
+        qInfo() << "Temperature history unavailable:" << file.errorString();
+        return false;
+    }
+
+    // Shared mapping: stores go to the page cache and on to the file
+    uchar *mapped = file.map(0, size);
+    if (!mapped) {
+        qInfo() << "Cannot map temperature history:" << file.errorString();
+        return false;
+    }
+    header = reinterpret_cast<Header *>(mapped);
+    records = reinterpret_cast<Record *>(mapped + sizeof(Header));
+
+    if (header->magic != HISTORY_MAGIC || header->version != HISTORY_VERSION || header->capacity != CAPACITY
+        || header->head >= CAPACITY || header->count > CAPACITY || header->unit != unit) {
+        std::memset(mapped, 0, size_t(size));
+        header->magic = HISTORY_MAGIC;
+        header->version = HISTORY_VERSION;
+        header->capacity = CAPACITY;
+        header->unit = unit;
+    }
+    return true;
+}
+
+TemperatureHistory::Unit TemperatureHistory::unitFor(const QString &name)
+{
+    if (name == "imperial") {
+        return FAHRENHEIT;
+    }
+    if (name == "standard") {
+        return KELVIN;
+    }
+    return CELSIUS;
+}
+
+void TemperatureHistory::append(quint32 time, Kind kind, double degrees)
+{
+    if (!header) {
+        return;
+    }
+
+    // The record is complete before the head makes it visible
+    Record &record = records[header->head];
+    record.time = time;
+    record.kind = kind;
+    record.reserved = 0;
+    record.centiDegrees = qint16(qBound(-32768.0, degrees * 100.0, 32767.0));
+    header->head = (header->head + 1) % CAPACITY;
+    if (header->count < CAPACITY) {
+        header->count++;
+    }
+}
+
+void TemperatureHistory::appendWeather(quint32 time, const CurrentWeather &weather)
+{
+    bool ok = false;
+    const double temperature = weather.temperature.toDouble(&ok);
+    if (ok) {
+        append(time, TEMPERATURE, temperature);
+    }
+    const double feelsLike = weather.feelsLike.toDouble(&ok);
+    if (ok) {
+        append(time, FEELS_LIKE, feelsLike);
+    }
+}
+
+void TemperatureHistory::appendForecast(const Forecast &forecast)
+{
+    for (int i = 0; i < forecast.count; ++i) {
+        const ForecastItem &day = forecast.days[i];
+
+        // Each day is filed at its local noon
+        const QDate date = QDate::fromString(day.date, "yyyy-MM-dd");
+        if (!date.isValid()) {
+            continue;
+        }
+        const quint32 time = quint32(QDateTime(date, QTime(12, 0)).toSecsSinceEpoch());
+
+        bool ok = false;
+        const double high = fromCelsius(day.maxTemp.toDouble(&ok));
+        if (ok && !recentlyRecorded(time, FORECAST_HIGH, qint16(high * 100.0))) {
+            append(time, FORECAST_HIGH, high);
+        }
+        const double low = fromCelsius(day.minTemp.toDouble(&ok));
+        if (ok && !recentlyRecorded(time, FORECAST_LOW, qint16(low * 100.0))) {
+            append(time, FORECAST_LOW, low);
+        }
+    }
+}
+
+quint32 TemperatureHistory::size() const
+{
+    return header ? header->count : 0;
+}
+
+const TemperatureHistory::Record &TemperatureHistory::at(quint32 index) const
+{
+    return records[(header->head + CAPACITY - header->count + index) % CAPACITY];
+}
+
+double TemperatureHistory::fromCelsius(double celsius) const
+{
+    switch (header ? header->unit : CELSIUS) {
+    case FAHRENHEIT:
+        return celsius * 9.0 / 5.0 + 32.0;
+    case KELVIN:
+        return celsius + 273.15;
+    default:
+        return celsius;
+    }
+}
+
+bool TemperatureHistory::recentlyRecorded(quint32 time, Kind kind, qint16 centiDegrees) const
+{
+    // The newest sample of the same day decides; older ones were revised
+    const quint32 count = size();
+    for (quint32 i = 0; i < qMin(count, FORECAST_LOOKBACK); ++i) {
+        const Record &record = at(count - 1 - i);
+        if (record.time == time && record.kind == kind) {
+            return record.centiDegrees == centiDegrees;
+        }
+    }
+    return false;
+}
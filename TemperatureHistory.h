@@ -0,0 +1,92 @@
+#ifndef TEMPERATUREHISTORY_H
+#define TEMPERATUREHISTORY_H
+
+#include <QFile>
+#include <QString>
+#include "FeedParser.h"
+
+// Weather readings and forecast samples kept in a fixed-size ring of 8 byte
+// records in a memory-mapped file. An append writes one record and the ring
+// head straight into the mapping, so it is O(1), allocates nothing and
+// needs no save; the kernel writes the pages back and the history survives
+// restarts. Loading a week of history is the one mmap done by open().
+class TemperatureHistory
+{
+public:
+    enum Kind : quint8 {
+        TEMPERATURE = 1,
+        FEELS_LIKE,
+        FORECAST_HIGH,
+        FORECAST_LOW
+    };
+
+    // Unit of the stored readings, as configured with UNIT
+    enum Unit : quint8 {
+        CELSIUS,
+        FAHRENHEIT,
+        KELVIN
+    };
+
+    struct Record {
+        // Seconds since the epoch
+        quint32 time;
+        quint8 kind;
+        quint8 reserved;
+        // Hundredths of a degree in the unit the history was opened with
+        qint16 centiDegrees;
+    };
+
+    // Four weeks of readings every 5 minutes plus forecast changes
+    static const quint32 CAPACITY = 16384;
+
+    // Uses the platform cache location when no path is given
+    explicit TemperatureHistory(const QString &path = QString());
+    ~TemperatureHistory();
+
+    // Maps the file, creating or resetting it if it is missing, invalid or
+    // kept in another unit
+    bool open(Unit unit);
+
+    // metric, imperial or standard, as OpenWeatherMap names them
+    static Unit unitFor(const QString &name);
+
+    void append(quint32 time, Kind kind, double degrees);
+
+    // Adds the current reading and feels-like temperature
+    void appendWeather(quint32 time, const CurrentWeather &weather);
+
+    // Adds the daily highs and lows that differ from those last recorded. The
+    // forecast is in Celsius whatever the unit.
+    void appendForecast(const Forecast &forecast);
+
+    quint32 size() const;
+
+    // Records from the oldest (0) to the newest (size() - 1)
+    const Record &at(quint32 index) const;
+
+private:
+    Q_DISABLE_COPY(TemperatureHistory)
+
+    struct Header {
+        quint32 magic;
+        quint32 version;
+        quint32 capacity;
+        // Index the next record is written to
+        quint32 head;
+        quint32 count;
+        // Unit of every record; zero, Celsius, in files written before it
+        quint32 unit;
+        quint32 reserved[2];
+    };
+
+    QFile file;
+    Header *header = nullptr;
+    Record *records = nullptr;
+
+    // Converts a forecast temperature to the unit of the records
+    double fromCelsius(double celsius) const;
+
+    bool recentlyRecorded(quint32 time, Kind kind, qint16 centiDegrees) const;
+};
+
+#endif // TEMPERATUREHISTORY_H
@@ -0,0 +1,235 @@
+#include "Trace.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QMutex>
+#include <QSaveFile>
+#include <QThread>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+
+namespace {
+// A sequence of 0 marks a slot being written; otherwise it is the write
+// index plus one, so a reader can tell a torn or overwritten copy
+struct Slot {
+    std::atomic<quint64> sequence{0};
+    const char *name;
+    const char *category;
+    qint64 startNs;
+    qint64 durationNs;
+    quint64 asyncId;
+    quint32 threadId;
+    char detail[Trace::DETAIL_SIZE];
+};
+
+struct Buffer {
+    std::atomic<bool> enabled{false};
+    std::atomic<quint64> head{0};
+    std::atomic<quint32> nextThreadId{1};
+    Slot slots[Trace::CAPACITY];
+
+    // Written once per thread, only read when dumping
+    QMutex threadMutex;
+    QMap<quint32, QString> threadNames;
+};
+
+Buffer &buffer()
+{
+    static Buffer instance;
+    return instance;
+}
+
+quint32 registerThread()
+{
+    Buffer &trace = buffer();
+    const quint32 id = trace.nextThreadId.fetch_add(1, std::memory_order_relaxed);
+
+    QThread *thread = QThread::currentThread();
+    QString name = thread->objectName();
+    if (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread()) {
+        name = "GUI";
+    } else if (name.isEmpty()) {
+        name = "Worker";
+    }
+
+    QMutexLocker locker(&trace.threadMutex);
+    trace.threadNames.insert(id, QString("%1 %2").arg(name).arg(id));
+    return id;
+}
+
+quint32 currentThreadId()
+{
+    thread_local quint32 id = registerThread();
+    return id;
+}
+
+void record(const char *name, const char *category, quint64 asyncId, qint64 startNs, qint64 endNs,
+            const char *detail)
+{
+    Buffer &trace = buffer();
+    if (!trace.enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    // Claiming a slot is the only shared step; the oldest span is overwritten
+    const quint64 index = trace.head.fetch_add(1, std::memory_order_relaxed);
+    Slot &slot = trace.slots[index % Trace::CAPACITY];
+
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name = name;
+    slot.category = category;
+    slot.startNs = startNs;
+    slot.durationNs = qMax<qint64>(0, endNs - startNs);
+    slot.asyncId = asyncId;
+    slot.threadId = currentThreadId();
+    if (detail) {
+        strncpy(slot.detail, detail, Trace::DETAIL_SIZE - 1);
+        slot.detail[Trace::DETAIL_SIZE - 1] = '\0';
+    } else {
+        slot.detail[0] = '\0';
+    }
+    slot.sequence.store(index + 1, std::memory_order_release);
+}
+}
+
+Trace::Span::Span(const char *name, const char *category, const char *detail)
+    : name(name),
+    category(category),
+    detail(detail),
+    startNs(isEnabled() ? now() : -1)
+{
+}
+
+Trace::Span::~Span()
+{
+    if (startNs >= 0) {
+        complete(name, category, startNs, now(), detail);
+    }
+}
+
+void Trace::setEnabled(bool enabled)
+{
+    buffer().enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool Trace::isEnabled()
+{
+    return buffer().enabled.load(std::memory_order_relaxed);
+}
+
+qint64 Trace::now()
+{
+    using Clock = std::chrono::steady_clock;
+    static const Clock::time_point epoch = Clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch).count();
+}
+
+void Trace::complete(const char *name, const char *category, qint64 startNs, qint64 endNs, const char *detail)
+{
+    record(name, category, 0, startNs, endNs, detail);
+}
+
+void Trace::async(const char *name, const char *category, quint64 id, qint64 startNs, qint64 endNs,
+                  const char *detail)
+{
+    // Id 0 is reserved for complete() spans
+    record(name, category, id + 1, startNs, endNs, detail);
+}
+
+QByteArray Trace::renderJson()
+{
+    Buffer &trace = buffer();
+    const qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray events;
+
+    const quint64 head = trace.head.load(std::memory_order_acquire);
+    const quint64 first = head > quint64(CAPACITY) ? head - CAPACITY : 0;
+    for (quint64 index = first; index < head; ++index) {
+        const Slot &slot = trace.slots[index % CAPACITY];
+        const quint64 sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence != index + 1) {
+            continue;
+        }
+
+        const char *name = slot.name;
+        const char *category = slot.category;
+        const qint64 startNs = slot.startNs;
+        const qint64 durationNs = slot.durationNs;
+        const quint64 asyncId = slot.asyncId;
+        const quint32 threadId = slot.threadId;
+        char detail[DETAIL_SIZE];
+        memcpy(detail, slot.detail, DETAIL_SIZE);
+        detail[DETAIL_SIZE - 1] = '\0';
+
+        // Skip the slot if a writer reused it while it was being copied
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != sequence) {
+            continue;
+        }
+
+        QJsonObject args;
+        if (detail[0] != '\0') {
+            args["detail"] = QString::fromUtf8(detail);
+        }
+
+        QJsonObject event{
+            {"name", name},
+            {"cat", category},
+            {"ts", startNs / 1000.0},
+            {"pid", pid},
+            {"tid", int(threadId)},
+            {"args", args},
+        };
+        if (asyncId == 0) {
+            event["ph"] = "X";
+            event["dur"] = durationNs / 1000.0;
+            events.append(event);
+        } else {
+            // Async spans are a begin and end pair matched by id
+            event["ph"] = "b";
+            event["id"] = QString::number(asyncId, 16);
+            events.append(event);
+            event["ph"] = "e";
+            event["ts"] = (startNs + durationNs) / 1000.0;
+            events.append(event);
+        }
+    }
+
+    QMutexLocker locker(&trace.threadMutex);
+    for (auto it = trace.threadNames.cbegin(); it != trace.threadNames.cend(); ++it) {
+        events.append(QJsonObject{
+            {"name", "thread_name"},
+            {"ph", "M"},
+            {"pid", pid},
+            {"tid", int(it.key())},
+            {"args", QJsonObject{{"name", it.value()}}},
+        });
+    }
+
+    QJsonObject document{
+        {"traceEvents", events},
+        {"displayTimeUnit", "ms"},
+    };
+    return QJsonDocument(document).toJson(QJsonDocument::Compact);
+}
+
+bool Trace::dump(const QString &path)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qInfo() << "Cannot write trace:" << file.errorString();
+        return false;
+    }
+    file.write(renderJson());
+    if (!file.commit()) {
+        qInfo() << "Cannot write trace:" << file.errorString();
+        return false;
+    }
+    qInfo() << "Trace written to" << path;
+    return true;
+}
@@ -0,0 +1,54 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QByteArray>
+#include <QString>
+
+// Opt-in span tracing in the Chrome trace-event format. Finished spans are
+// written into a fixed ring buffer without locks, so any thread can record;
+// the newest spans are kept and can be dumped for chrome://tracing or
+// Perfetto at any time. While disabled recording costs one atomic load.
+class Trace
+{
+public:
+    static const int CAPACITY = 16384;
+    static const int DETAIL_SIZE = 48;
+
+    // Nested spans on one thread show up as a call stack in the viewer
+    class Span
+    {
+    public:
+        // name and category must be string literals; detail is copied when
+        // the span ends
+        Span(const char *name, const char *category, const char *detail = nullptr);
+        ~Span();
+
+    private:
+        const char *name;
+        const char *category;
+        const char *detail;
+        qint64 startNs;
+    };
+
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+
+    // Monotonic nanoseconds since the first call
+    static qint64 now();
+
+    // Records a span whose start and end were taken with now(), for stages
+    // that begin and end in different callbacks
+    static void complete(const char *name, const char *category, qint64 startNs, qint64 endNs,
+                         const char *detail = nullptr);
+
+    // Like complete(), for stages that overlap others on the same thread,
+    // e.g. concurrent requests. Spans sharing an id are drawn on one track.
+    static void async(const char *name, const char *category, quint64 id, qint64 startNs, qint64 endNs,
+                      const char *detail = nullptr);
+
+    // All buffered spans as a trace-event JSON document
+    static QByteArray renderJson();
+    static bool dump(const QString &path);
+};
+
+#endif // TRACE_H
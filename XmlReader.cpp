@@ -1,22 +1,76 @@
 #include "XmlReader.h"
-#include <QXmlStreamReader>
+#include "NetworkService.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QLocale>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QPointer>
+#include <QQueue>
+#include <QRunnable>
+#include <QThreadPool>
+
+// State shared between the GUI thread and the worker parsing one document
+struct XmlReader::ParseJob {
+    explicit ParseJob(const FeedCache &cache) : cache(cache) {}
+
+    // Guarded by mutex
+    QMutex mutex;
+    QQueue<QByteArray> chunks;
+    bool endOfData = false;
+    bool running = false;
+    FeedCache::Entry validators;
+
+    // Only touched by the worker
+    FeedParser parser;
+    FeedParser::Status status = FeedParser::NeedMoreData;
+    QByteArray body;
+
+    // Only touched on the GUI thread
+    QPointer<XmlReader> reader;
+
+    // Immutable after creation
+    FeedCache cache;
+    QUrl url;
+    int itemLimit = 0;
+    bool storeInCache = true;
+    Metrics::Histogram *parseDuration = nullptr;
+    Metrics::Gauge *parsedItems = nullptr;
+    QByteArray traceDetail;
+    qint64 parseNs = 0;
+};
+
+namespace {
+QString feedName(XmlType type)
+{
+    switch (type) {
+    case XmlType::NEWS: return "news";
+    case XmlType::WEATHER: return "weather";
+    case XmlType::FORECAST: return "forecast";
+    }
+    return "unknown";
+}
+}
 
 XmlReader::XmlReader(QObject *parent)
-    : QObject(parent),
-    networkManager(new QNetworkAccessManager(this))
+    : QObject(parent)
 {
-    // Connect the finished signal of the network manager to our slot
-    connect(networkManager, &QNetworkAccessManager::finished,
-            this, &XmlReader::onReplyFinished);
 }
 
 XmlReader::~XmlReader()
 {
-    // QNetworkAccessManager is deleted automatically because of QObject parent
+    // Replies belong to the shared network manager, so cancel ours explicitly
+    if (currentReply) {
+        QNetworkReply *reply = currentReply;
+        currentReply = nullptr;
+        reply->abort();
+    }
 }
 
-void XmlReader::loadFeed(const QUrl &url, const XmlType &newType)
+void XmlReader::loadFeed(const QUrl &url, const XmlType &newType, int itemLimit, FeedFields fields)
 {
     if (!url.isValid()) {
         emit errorOccurred("Invalid URL.");
@@ -24,91 +78,311 @@ void XmlReader::loadFeed(const QUrl &url, const XmlType &newType)
     }
 
     type = newType;
+    limit = itemLimit;
+    projection = fields;
+
+    // Load validators persisted by a previous run once per URL
+    if (url != cachedUrl) {
+        cachedUrl = url;
+        cached = cache.load(url);
+        itemsParsed = false;
+
+        const QString labels = QString("feed=\"%1\",host=\"%2\"").arg(feedName(type), url.host());
+        fetchDuration = &Metrics::histogram("pidashboard_fetch_duration_seconds", "Time from request start to end of transfer.", labels);
+        fetchBytes = &Metrics::counter("pidashboard_fetch_bytes_total", "Response body bytes received.", labels);
+        fetchErrors = &Metrics::counter("pidashboard_fetch_errors_total", "Failed fetches and parses.", labels);
+        parseDuration = &Metrics::histogram("pidashboard_parse_duration_seconds", "Parser time per document.", labels);
+        parsedItems = &Metrics::gauge("pidashboard_parse_items", "Items in the last parsed document.", labels);
+        traceDetail = feedName(type).toUtf8();
+    }
+
+    // Parsing a body cut short at a smaller limit would fail at its end
+    if (cached.isValid() && !cached.servesLimit(limit)) {
+        cached = FeedCache::Entry();
+    }
+
+    // A newer request supersedes one still queued or in flight
+    const quint64 generation = ++requestGeneration;
+    if (currentReply) {
+        QNetworkReply *previous = currentReply;
+        currentReply = nullptr;
+        previous->abort();
+    }
+    job.reset();
+
     QNetworkRequest request(url);
-    networkManager->get(request);
+    FeedCache::applyValidators(request, cached);
+    NetworkService::instance()->get(request, this, [this, generation](QNetworkReply *reply) {
+        if (generation != requestGeneration) {
+            reply->abort();
+            reply->deleteLater();
+            return;
+        }
+
+        currentReply = reply;
+        fetchTimer.start();
+        startJob(true);
+        connect(reply, &QNetworkReply::readyRead, this, &XmlReader::onReplyReadyRead);
+        connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+            onReplyFinished(reply);
+        });
+    });
+}
+
+const FeedResult &XmlReader::getResult() const
+{
+    return result;
+}
+
+int XmlReader::freshnessSeconds() const
+{
+    return qMax(httpFreshness, ttlFreshness);
 }
 
-QList<XmlItem> XmlReader::getItems() const
+void XmlReader::readFreshness(const QNetworkReply *reply)
 {
-    return items;
+    httpFreshness = -1;
+
+    const QByteArray cacheControl = reply->rawHeader("Cache-Control");
+    for (const QByteArray &directive : cacheControl.split(',')) {
+        const QByteArray trimmed = directive.trimmed();
+        if (trimmed.startsWith("max-age=")) {
+            bool ok = false;
+            int maxAge = trimmed.mid(8).toInt(&ok);
+            if (ok) {
+                httpFreshness = maxAge;
+                return;
+            }
+        }
+    }
+
+    // HTTP dates look like "Tue, 14 May 2024 09:42:11 GMT"
+    const QByteArray expires = reply->rawHeader("Expires");
+    if (!expires.isEmpty()) {
+        QDateTime expiry = QLocale::c().toDateTime(QString::fromLatin1(expires.trimmed()), "ddd, dd MMM yyyy HH:mm:ss 'GMT'");
+        if (expiry.isValid()) {
+            expiry.setTimeSpec(Qt::UTC);
+            httpFreshness = qMax<qint64>(0, QDateTime::currentDateTimeUtc().secsTo(expiry));
+        }
+    }
+}
+
+void XmlReader::onReplyReadyRead()
+{
+    QNetworkReply *reply = qobject_cast<QNetworkReply *>(sender());
+    if (reply != currentReply || !job) {
+        return;
+    }
+
+    // Error pages and 304s are left for onReplyFinished
+    int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status != 200) {
+        return;
+    }
+
+    readFreshness(reply);
+    QByteArray chunk = reply->readAll();
+    fetchBytes->add(chunk.size());
+    enqueue(job, chunk, false, FeedCache::fromReply(reply, QByteArray()));
 }
 
 void XmlReader::onReplyFinished(QNetworkReply *reply)
 {
+    if (reply != currentReply) {
+        // Superseded, aborted early or already handled
+        reply->deleteLater();
+        return;
+    }
+    currentReply = nullptr;
+    fetchDuration->observeNs(fetchTimer.nsecsElapsed());
+
     if (reply->error() != QNetworkReply::NoError) {
+        job.reset();
+        fetchErrors->add();
         emit errorOccurred(reply->errorString());
         reply->deleteLater();
         return;
     }
 
-    parseFeed(reply);
+    FeedCache::Stats &stats = FeedCache::stats();
+    int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    readFreshness(reply);
+
+    if (status == 304 && !cached.isValid()) {
+        // Nothing to reuse, so ask again without validators, but only once
+        reply->deleteLater();
+        job.reset();
+        if (refetchingUnmodified) {
+            refetchingUnmodified = false;
+            fetchErrors->add();
+            emit errorOccurred("Not modified, but no cached copy");
+            return;
+        }
+        qInfo() << "Feed not modified but not cached, refetching:" << cachedUrl.host();
+        refetchingUnmodified = true;
+        loadFeed(cachedUrl, type, limit, projection);
+        return;
+    }
+    refetchingUnmodified = false;
+
+    if (status == 304) {
+        stats.hits++;
+        stats.bytesSaved += cached.body.size();
+        reply->deleteLater();
+
+        // Only a fresh process has to parse the cached body
+        if (!itemsParsed) {
+            enqueue(startJob(false), cached.body, true, cached);
+            return;
+        }
+
+        job.reset();
+        emit feedNotModified();
+        return;
+    }
+
+    if (job) {
+        QByteArray chunk = reply->readAll();
+        fetchBytes->add(chunk.size());
+        enqueue(job, chunk, true, FeedCache::fromReply(reply, QByteArray()));
+    }
     reply->deleteLater();
 }
 
-void XmlReader::parseFeed(QIODevice *device)
+std::shared_ptr<XmlReader::ParseJob> XmlReader::startJob(bool storeInCache)
+{
+    job = std::make_shared<ParseJob>(cache);
+    job->parser.reset(type, limit, projection);
+    job->reader = this;
+    job->url = cachedUrl;
+    job->itemLimit = limit;
+    job->storeInCache = storeInCache;
+    job->parseDuration = parseDuration;
+    job->parsedItems = parsedItems;
+    job->traceDetail = traceDetail;
+    return job;
+}
+
+void XmlReader::enqueue(const std::shared_ptr<ParseJob> &parseJob, const QByteArray &chunk,
+                        bool endOfData, const FeedCache::Entry &validators)
 {
-    items.clear();
-
-    QXmlStreamReader xml(device);
-    bool inItem = false;
-    NewsItem newsItem;
-    ForecastItem forecastItem;
-
-    while (!xml.atEnd() && !xml.hasError()) {
-        QXmlStreamReader::TokenType token = xml.readNext();
-
-        if (token == QXmlStreamReader::StartElement) {
-            QString name = xml.name().toString();
-
-            if (name == XmlTag.at(XmlTagEnum::NEWS_START) || (name == XmlTag.at(XmlTagEnum::WEATHER_START) && type == XmlType::WEATHER) || name == XmlTag.at(XmlTagEnum::FORECAST_START)) {
-                inItem = true;
-            } else if (inItem) {
-                if (type == XmlType::NEWS) {
-                    if (name == "title") newsItem.title = xml.readElementText();
-                    else if (name == "link") newsItem.link = xml.readElementText();
-                    else if (name == "description") newsItem.description = xml.readElementText();
-                    else if (name == "pubDate") newsItem.pubDate = xml.readElementText();
-                } else if (type == XmlType::WEATHER && name == "temperature") {
-                    TemperatureItem tempItem;
-                    QXmlStreamAttributes attributes = xml.attributes();
-                    tempItem.temperature = attributes.value("value").toString();
-                    items.append(tempItem);
-                } else if (type == XmlType::WEATHER && name == "feels_like") {
-                    FeelsLikeItem feelsItem;
-                    QXmlStreamAttributes attributes = xml.attributes();
-                    feelsItem.feelsLike = attributes.value("value").toString();
-                    items.append(feelsItem);
-                } else if (type == XmlType::WEATHER && name == "weather") {
-                    WeatherItem weatherItem;
-                    QXmlStreamAttributes attributes = xml.attributes();
-                    weatherItem.weather = attributes.value("value").toString();
-                    items.append(weatherItem);
-                } else if (type == XmlType::FORECAST) {
-                    if (name == "maxtemp_c") forecastItem.maxTemp = xml.readElementText();
-                    else if (name == "mintemp_c") forecastItem.minTemp = xml.readElementText();
-                    else if (name == "date") forecastItem.date = xml.readElementText();
-                    else if (name == "daily_chance_of_rain") forecastItem.rainChance = xml.readElementText();
-                    else if (name == "icon") forecastItem.icon = xml.readElementText();
-                }
+    QMutexLocker locker(&parseJob->mutex);
+    if (!chunk.isEmpty()) {
+        parseJob->chunks.enqueue(chunk);
+    }
+    parseJob->endOfData = parseJob->endOfData || endOfData;
+    if (!validators.etag.isEmpty() || !validators.lastModified.isEmpty()) {
+        parseJob->validators = validators;
+    }
+
+    if (!parseJob->running) {
+        parseJob->running = true;
+        std::shared_ptr<ParseJob> worker = parseJob;
+        QThreadPool::globalInstance()->start(QRunnable::create([worker]() {
+            drain(worker);
+        }));
+    }
+}
+
+void XmlReader::drain(const std::shared_ptr<ParseJob> &parseJob)
+{
+    forever {
+        QByteArray chunk;
+        bool atEnd = false;
+        FeedCache::Entry entry;
+        {
+            QMutexLocker locker(&parseJob->mutex);
+            if (parseJob->chunks.isEmpty() && !parseJob->endOfData) {
+                parseJob->running = false;
+                return;
             }
-        } else if (token == QXmlStreamReader::EndElement) {
-            QString name = xml.name().toString();
-
-            if ((name == XmlTag.at(XmlTagEnum::NEWS_END) || (name == XmlTag.at(XmlTagEnum::WEATHER_END) && type == XmlType::WEATHER) || name == XmlTag.at(XmlTagEnum::FORECAST_END)) && inItem) {
-                inItem = false;
-                if (name == XmlTag.at(XmlTagEnum::NEWS_END)) {
-                    items.append(newsItem);
-                } else if (name == XmlTag.at(XmlTagEnum::FORECAST_END)) {
-                    items.append(forecastItem);
-                }
+            if (!parseJob->chunks.isEmpty()) {
+                chunk = parseJob->chunks.dequeue();
+            } else {
+                atEnd = true;
+                parseJob->endOfData = false;
             }
+            entry = parseJob->validators;
+        }
+
+        if (parseJob->status != FeedParser::NeedMoreData) {
+            // Already published; the rest of the transfer is being dropped
+            continue;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        if (atEnd) {
+            Trace::Span span("finish", "parse", parseJob->traceDetail.constData());
+            parseJob->status = parseJob->parser.finish();
+        } else {
+            Trace::Span span("parse chunk", "parse", parseJob->traceDetail.constData());
+            parseJob->body.append(chunk);
+            parseJob->status = parseJob->parser.addData(chunk);
+        }
+        parseJob->parseNs += timer.nsecsElapsed();
+
+        if (parseJob->status == FeedParser::NeedMoreData) {
+            continue;
+        }
+
+        FeedResult newResult = parseJob->parser.takeResult();
+        QString error = parseJob->parser.errorString();
+        FeedParser::Status status = parseJob->status;
+        int ttlMinutes = parseJob->parser.ttlMinutes();
+        parseJob->parseDuration->observeNs(parseJob->parseNs);
+        parseJob->parsedItems->set(newResult.itemCount());
+
+        // A body cut short by the item limit reproduces the same items, but
+        // only for limits up to this one
+        entry.body = parseJob->body;
+        entry.itemLimit = status == FeedParser::LimitReached ? parseJob->itemLimit : 0;
+        if (status != FeedParser::Error && parseJob->storeInCache) {
+            Trace::Span span("store", "cache", parseJob->traceDetail.constData());
+            parseJob->cache.store(parseJob->url, entry);
         }
+
+        // The GUI thread only swaps in the finished list
+        std::shared_ptr<ParseJob> finished = parseJob;
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [finished, status, newResult, error, entry, ttlMinutes]() {
+            if (XmlReader *reader = finished->reader) {
+                reader->publishResult(finished, status, newResult, error, entry, ttlMinutes);
+            }
+        }, Qt::QueuedConnection);
     }
+}
 
-    if (xml.hasError()) {
-        emit errorOccurred("XML Parsing Error: " + xml.errorString());
+void XmlReader::publishResult(const std::shared_ptr<ParseJob> &parseJob, FeedParser::Status status,
+                              const FeedResult &newResult, const QString &error, const FeedCache::Entry &entry,
+                              int ttlMinutes)
+{
+    if (parseJob != job) {
         return;
     }
+    job.reset();
+    Trace::Span span("publish", "gui", traceDetail.constData());
+
+    // Enough items were parsed or the document is broken, stop the transfer
+    if (currentReply) {
+        QNetworkReply *reply = currentReply;
+        currentReply = nullptr;
+        fetchDuration->observeNs(fetchTimer.nsecsElapsed());
+        reply->abort();
+    }
+
+    if (status == FeedParser::Error) {
+        fetchErrors->add();
+        emit errorOccurred("XML Parsing Error: " + error);
+        return;
+    }
+
+    if (parseJob->storeInCache) {
+        FeedCache::stats().misses++;
+    }
 
+    result = newResult;
+    itemsParsed = true;
+    ttlFreshness = ttlMinutes > 0 ? ttlMinutes * 60 : -1;
+    cached = entry;
     emit feedLoaded();
 }
@@ -3,64 +3,16 @@
 
 #include <QObject>
 #include <QList>
-#include <QNetworkAccessManager>
+#include <QElapsedTimer>
 #include <QNetworkReply>
-
-// Structures to hold XML data
-struct NewsItem {
-    QString title;
-    QString link;
-    QString description;
-    QString pubDate;
-};
-
-struct TemperatureItem {
-    QString temperature;
-};
-
-struct FeelsLikeItem {
-    QString feelsLike;
-};
-
-struct WeatherItem {
-    QString weather;
-};
-
-struct ForecastItem {
-    QString date;
-    QString maxTemp;
-    QString minTemp;
-    QString rainChance;
-    QString icon;
-};
-
-using XmlItem = std::variant<NewsItem, TemperatureItem, FeelsLikeItem, WeatherItem, ForecastItem>;
-
-enum XmlType {
-    NEWS,
-    WEATHER,
-    FORECAST
-};
-
-enum XmlTagEnum {
-    NEWS_START,
-    NEWS_END,
-    WEATHER_START,
-    WEATHER_END,
-    FORECAST_START,
-    FORECAST_END
-};
-
-static std::map<XmlTagEnum, const char *> XmlTag = {
-    {XmlTagEnum::NEWS_START, "item"},
-    {XmlTagEnum::NEWS_END, "item"},
-    {XmlTagEnum::WEATHER_START, "current"},
-    {XmlTagEnum::WEATHER_END, "current"},
-    {XmlTagEnum::FORECAST_START, "forecastday"},
-    {XmlTagEnum::FORECAST_END, "day"}
-};
-
-// XmlReader class definition
+#include <memory>
+#include "FeedCache.h"
+#include "FeedParser.h"
+#include "Metrics.h"
+
+// XmlReader class definition. Network I/O happens on the GUI thread while
+// parsing runs on the global thread pool; results are published back to
+// the GUI thread as shared, immutable typed results.
 class XmlReader : public QObject
 {
     Q_OBJECT
@@ -68,30 +20,81 @@ public:
     explicit XmlReader(QObject *parent = nullptr);
     ~XmlReader();
 
-    // Method to load XML feed from a given URL
-    void loadFeed(const QUrl &url, const XmlType &newType);
+    // Method to load XML feed from a given URL. With a positive item limit
+    // the transfer is aborted as soon as that many items have been parsed.
+    // Only the projected fields are decoded; the others stay empty.
+    void loadFeed(const QUrl &url, const XmlType &newType, int itemLimit = 0,
+                  FeedFields fields = ALL_FEED_FIELDS);
 
-    // Getter for the list of XML items
-    QList<XmlItem> getItems() const;
+    // The last parsed document; only the member for the feed type is set
+    const FeedResult &getResult() const;
+
+    // Seconds the last response stays fresh according to Cache-Control,
+    // Expires or RSS <ttl>, whichever is longest; -1 without any hint
+    int freshnessSeconds() const;
 
 signals:
     // Emitted when the feed is successfully loaded and parsed
     void feedLoaded();
 
+    // Emitted when the server reports the feed unchanged since the last parse
+    void feedNotModified();
+
     // Emitted when an error occurs
     void errorOccurred(const QString &errorString);
 
 private slots:
+    // Slot to hand newly received data to the parse worker
+    void onReplyReadyRead();
+
     // Slot to handle the network reply
     void onReplyFinished(QNetworkReply *reply);
 
 private:
-    QNetworkAccessManager *networkManager;
-    QList<XmlItem> items;
-    XmlType type;
+    struct ParseJob;
 
-    // Helper method to parse the XML feed
-    void parseFeed(QIODevice *device);
+    QNetworkReply *currentReply = nullptr;
+    quint64 requestGeneration = 0;
+    std::shared_ptr<ParseJob> job;
+    FeedResult result;
+    XmlType type;
+    int limit = 0;
+    FeedFields projection = ALL_FEED_FIELDS;
+    FeedCache cache;
+    FeedCache::Entry cached;
+    QUrl cachedUrl;
+    bool itemsParsed = false;
+    // Set while refetching after a 304 for which nothing was cached
+    bool refetchingUnmodified = false;
+    int httpFreshness = -1;
+    int ttlFreshness = -1;
+
+    // Per feed metric series, looked up once per URL
+    QElapsedTimer fetchTimer;
+    Metrics::Histogram *fetchDuration = nullptr;
+    Metrics::Counter *fetchBytes = nullptr;
+    Metrics::Counter *fetchErrors = nullptr;
+    Metrics::Histogram *parseDuration = nullptr;
+    Metrics::Gauge *parsedItems = nullptr;
+    QByteArray traceDetail;
+
+    // Reads Cache-Control max-age or Expires from the response headers
+    void readFreshness(const QNetworkReply *reply);
+
+    // Starts a parse job for a new document, replacing any previous one
+    std::shared_ptr<ParseJob> startJob(bool storeInCache);
+
+    // Queues data for the worker; validators are recorded with the body
+    static void enqueue(const std::shared_ptr<ParseJob> &parseJob, const QByteArray &chunk,
+                        bool endOfData, const FeedCache::Entry &validators = FeedCache::Entry());
+
+    // Runs on a worker thread and parses everything queued so far
+    static void drain(const std::shared_ptr<ParseJob> &parseJob);
+
+    // Called on the GUI thread with the outcome of a parse job
+    void publishResult(const std::shared_ptr<ParseJob> &parseJob, FeedParser::Status status,
+                       const FeedResult &newResult, const QString &error, const FeedCache::Entry &entry,
+                       int ttlMinutes);
 };
 
 #endif // XMLREADER_H
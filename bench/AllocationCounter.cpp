@@ -0,0 +1,203 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#ifdef __GLIBC__
+#include <cerrno>
+#include <malloc.h>
+#endif
+
+namespace {
+std::atomic<quint64> allocations{0};
+std::atomic<quint64> live{0};
+std::atomic<quint64> peak{0};
+
+void added(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    quint64 now = live.fetch_add(size, std::memory_order_relaxed) + size;
+    quint64 seen = peak.load(std::memory_order_relaxed);
+    while (now > seen && !peak.compare_exchange_weak(seen, now, std::memory_order_relaxed)) {
+    }
+}
+
+void removed(std::size_t size)
+{
+    live.fetch_sub(size, std::memory_order_relaxed);
+}
+}
+
+#ifdef __GLIBC__
+
+// Qt's containers and the XML reader's buffers call malloc directly, so the
+// C allocator itself is replaced and operator new, which calls malloc, is
+// counted through it. Sizes are the usable size of each block.
+extern "C" {
+void *__libc_malloc(std::size_t size);
+void *__libc_calloc(std::size_t count, std::size_t size);
+void *__libc_realloc(void *ptr, std::size_t size);
+void *__libc_memalign(std::size_t alignment, std::size_t size);
+void __libc_free(void *ptr);
+
+void *malloc(std::size_t size)
+{
+    void *ptr = __libc_malloc(size);
+    if (ptr) {
+        added(malloc_usable_size(ptr));
+    }
+    return ptr;
+}
+
+void *calloc(std::size_t count, std::size_t size)
+{
+    void *ptr = __libc_calloc(count, size);
+    if (ptr) {
+        added(malloc_usable_size(ptr));
+    }
+    return ptr;
+}
+
+void *realloc(void *ptr, std::size_t size)
+{
+    const std::size_t before = ptr ? malloc_usable_size(ptr) : 0;
+    void *moved = __libc_realloc(ptr, size);
+    if (moved) {
+        removed(before);
+        added(malloc_usable_size(moved));
+    } else if (ptr && size == 0) {
+        removed(before);
+    }
+    return moved;
+}
+
+void *memalign(std::size_t alignment, std::size_t size)
+{
+    void *ptr = __libc_memalign(alignment, size);
+    if (ptr) {
+        added(malloc_usable_size(ptr));
+    }
+    return ptr;
+}
+
+void *aligned_alloc(std::size_t alignment, std::size_t size)
+{
+    return memalign(alignment, size);
+}
+
+int posix_memalign(void **result, std::size_t alignment, std::size_t size)
+{
+    if (alignment < sizeof(void *) || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    void *ptr = memalign(alignment, size);
+    if (!ptr) {
+        return ENOMEM;
+    }
+    *result = ptr;
+    return 0;
+}
+
+void free(void *ptr)
+{
+    if (ptr) {
+        removed(malloc_usable_size(ptr));
+        __libc_free(ptr);
+    }
+}
+}
+
+#else
+
+// Elsewhere only operator new is counted. Each block carries its size in a
+// header so frees can be accounted for.
+namespace {
+static const std::size_t HEADER_SIZE = alignof(std::max_align_t);
+
+void *allocate(std::size_t size)
+{
+    char *block = static_cast<char *>(std::malloc(size + HEADER_SIZE));
+    if (!block) {
+        throw std::bad_alloc();
+    }
+    *reinterpret_cast<std::size_t *>(block) = size;
+    added(size);
+    return block + HEADER_SIZE;
+}
+
+void release(void *ptr)
+{
+    if (!ptr) {
+        return;
+    }
+    char *block = static_cast<char *>(ptr) - HEADER_SIZE;
+    removed(*reinterpret_cast<std::size_t *>(block));
+    std::free(block);
+}
+}
+
+void *operator new(std::size_t size)
+{
+    return allocate(size);
+}
+
+void *operator new[](std::size_t size)
+{
+    return allocate(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    release(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    release(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    release(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+    release(ptr);
+}
+
+#endif
+
+namespace AllocationCounter {
+
+bool countsMalloc()
+{
+#ifdef __GLIBC__
+    return true;
+#else
+    return false;
+#endif
+}
+
+quint64 count()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+quint64 liveBytes()
+{
+    return live.load(std::memory_order_relaxed);
+}
+
+quint64 peakBytes()
+{
+    return peak.load(std::memory_order_relaxed);
+}
+
+void resetPeak()
+{
+    peak.store(live.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+}
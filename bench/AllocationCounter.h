@@ -0,0 +1,28 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <QtGlobal>
+
+// Heap allocation hooks shared by the benchmark targets. Linking
+// AllocationCounter.cpp into a target replaces malloc and free on glibc, which
+// covers operator new and Qt's own buffers, and only operator new elsewhere.
+namespace AllocationCounter {
+
+// Whether malloc itself is counted, or only operator new
+bool countsMalloc();
+
+// Number of allocations made so far
+quint64 count();
+
+// Bytes currently allocated through the replaced allocator
+quint64 liveBytes();
+
+// Highest liveBytes() seen since the last resetPeak()
+quint64 peakBytes();
+
+// Restarts peak tracking from the current live byte count
+void resetPeak();
+
+}
+
+#endif // ALLOCATIONCOUNTER_H
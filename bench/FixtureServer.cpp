@@ -0,0 +1,153 @@
+#include "FixtureServer.h"
+#include <QDebug>
+#include <QFile>
+#include <QTcpSocket>
+#include <QTimer>
+
+namespace {
+static const int MAX_REQUEST_BYTES = 16384;
+
+struct Route {
+    const char *path;
+    const char *file;
+};
+
+const Route ROUTES[] = {
+    {"/news.xml", "bbc_world_rss.xml"},
+    {"/weather.xml", "owm_current.xml"},
+    {"/forecast.xml", "weatherapi_forecast.xml"}
+};
+
+bool readFile(const QString &path, QByteArray *data)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qInfo() << "Cannot open fixture" << path;
+        return false;
+    }
+    *data = file.readAll();
+    return true;
+}
+
+QByteArray response(const QByteArray &status, const QByteArray &contentType, const QByteArray &body)
+{
+    return "HTTP/1.1 " + status + "\r\n"
+           "Content-Type: " + contentType + "\r\n"
+           "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+           "Connection: close\r\n\r\n" + body;
+}
+}
+
+FixtureServer::FixtureServer(QObject *parent)
+    : QObject(parent)
+{
+    connect(&server, &QTcpServer::newConnection, this, &FixtureServer::onNewConnection);
+}
+
+bool FixtureServer::start(const QString &fixtureDir)
+{
+    for (const Route &route : ROUTES) {
+        QByteArray data;
+        if (!readFile(fixtureDir + "/" + route.file, &data)) {
+            return false;
+        }
+        documents.insert(route.path, data);
+    }
+    if (!readFile(fixtureDir + "/icon.png", &icon)) {
+        return false;
+    }
+
+    if (!server.listen(QHostAddress::LocalHost, 0)) {
+        qInfo() << "Fixture server unavailable:" << server.errorString();
+        return false;
+    }
+    return true;
+}
+
+QString FixtureServer::baseUrl() const
+{
+    return QString("http://127.0.0.1:%1").arg(server.serverPort());
+}
+
+int FixtureServer::requestsServed() const
+{
+    return served;
+}
+
+void FixtureServer::setNewsRevision(int revision)
+{
+    newsRevision = revision;
+}
+
+void FixtureServer::setChunking(int bytes, int intervalMs)
+{
+    chunkBytes = bytes;
+    chunkIntervalMs = intervalMs;
+}
+
+void FixtureServer::onNewConnection()
+{
+    while (QTcpSocket *socket = server.nextPendingConnection()) {
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {
+            if (socket->bytesAvailable() > MAX_REQUEST_BYTES) {
+                socket->abort();
+                return;
+            }
+            if (!socket->peek(MAX_REQUEST_BYTES).contains("\r\n\r\n")) {
+                return;
+            }
+            const QByteArray data = respond(socket->readAll());
+            if (chunkBytes > 0) {
+                sendChunked(socket, data);
+                return;
+            }
+            socket->write(data);
+            socket->disconnectFromHost();
+        });
+    }
+}
+
+void FixtureServer::sendChunked(QTcpSocket *socket, const QByteArray &data)
+{
+    // Owned by the socket, so a client that goes away stops the transfer
+    QTimer *timer = new QTimer(socket);
+    connect(timer, &QTimer::timeout, socket, [this, socket, timer, data, sent = 0]() mutable {
+        socket->write(data.mid(sent, chunkBytes));
+        sent += chunkBytes;
+        if (sent >= data.size()) {
+            timer->stop();
+            socket->disconnectFromHost();
+        }
+    });
+    timer->start(chunkIntervalMs);
+}
+
+QByteArray FixtureServer::respond(const QByteArray &request)
+{
+    // Request line: GET /path?query HTTP/1.1
+    const QList<QByteArray> requestLine = request.left(request.indexOf("\r\n")).split(' ');
+    if (requestLine.size() < 2 || requestLine.at(0) != "GET") {
+        return response("405 Method Not Allowed", "text/plain", QByteArray());
+    }
+
+    QByteArray path = requestLine.at(1);
+    const int query = path.indexOf('?');
+    if (query >= 0) {
+        path.truncate(query);
+    }
+
+    served++;
+    if (path == "/news.xml" && newsRevision > 0) {
+        QByteArray news = documents.value(path);
+        news.replace("]]></title>", " #" + QByteArray::number(newsRevision) + "]]></title>");
+        return response("200 OK", "application/xml; charset=utf-8", news);
+    }
+    if (documents.contains(path)) {
+        return response("200 OK", "application/xml; charset=utf-8", documents.value(path));
+    }
+    if (path.endsWith(".png")) {
+        return response("200 OK", "image/png", icon);
+    }
+    return response("404 Not Found", "text/plain", QByteArray());
+}
@@ -0,0 +1,49 @@
+#ifndef FIXTURESERVER_H
+#define FIXTURESERVER_H
+
+#include <QHash>
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+// Local stand-in for the feed and icon hosts. Serves the recorded documents
+// from bench/fixtures over plain HTTP on 127.0.0.1:
+//   /news.xml, /weather.xml, /forecast.xml and any path ending in .png
+class FixtureServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FixtureServer(QObject *parent = nullptr);
+
+    // Loads the fixtures and listens on a free port
+    bool start(const QString &fixtureDir);
+
+    QString baseUrl() const;
+    int requestsServed() const;
+
+    // Appends the revision to every news title, so each refresh brings new
+    // headlines; 0 serves the recorded titles
+    void setNewsRevision(int revision);
+
+    // Sends each response in pieces of the given size, one per interval, like
+    // a slow link; 0 sends them whole
+    void setChunking(int bytes, int intervalMs);
+
+private slots:
+    void onNewConnection();
+
+private:
+    QTcpServer server;
+    QHash<QByteArray, QByteArray> documents;
+    QByteArray icon;
+    int served = 0;
+    int newsRevision = 0;
+    int chunkBytes = 0;
+    int chunkIntervalMs = 0;
+
+    QByteArray respond(const QByteArray &request);
+    void sendChunked(QTcpSocket *socket, const QByteArray &data);
+};
+
+#endif // FIXTURESERVER_H
@@ -0,0 +1,184 @@
+// Microbenchmark comparing the original string-based tag dispatch of
+// parseFeed with FeedParser's allocation-free tag tables.
+//
+// Usage: ParserMicroBench [fixture-dir]
+
+#include "FeedParser.h"
+#include "AllocationCounter.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include <QXmlStreamReader>
+#include <cstdlib>
+#include <map>
+#include <variant>
+
+namespace {
+static const int MIN_ITERATIONS = 50;
+static const qint64 MIN_DURATION_NS = 500 * 1000 * 1000;
+
+// The item list parseFeed produced before the typed results
+struct TemperatureItem {
+    QString temperature;
+};
+
+struct FeelsLikeItem {
+    QString feelsLike;
+};
+
+struct WeatherItem {
+    QString weather;
+};
+
+using XmlItem = std::variant<NewsItem, TemperatureItem, FeelsLikeItem, WeatherItem, ForecastItem>;
+
+// The dispatch parseFeed used before the tag tables, kept for comparison
+const std::map<int, const char *> LEGACY_TAGS = {
+    {0, "item"},
+    {1, "current"},
+    {2, "forecastday"},
+    {3, "day"}
+};
+
+int legacyParse(const QByteArray &data, XmlType type)
+{
+    QList<XmlItem> items;
+    QXmlStreamReader xml(data);
+    bool inItem = false;
+    NewsItem newsItem;
+    ForecastItem forecastItem;
+
+    while (!xml.atEnd() && !xml.hasError()) {
+        QXmlStreamReader::TokenType token = xml.readNext();
+
+        if (token == QXmlStreamReader::StartElement) {
+            QString name = xml.name().toString();
+
+            if (name == LEGACY_TAGS.at(0) || (name == LEGACY_TAGS.at(1) && type == XmlType::WEATHER) || name == LEGACY_TAGS.at(2)) {
+                inItem = true;
+            } else if (inItem) {
+                if (type == XmlType::NEWS) {
+                    if (name == "title") newsItem.title = xml.readElementText();
+                    else if (name == "link") newsItem.link = xml.readElementText();
+                    else if (name == "description") newsItem.description = xml.readElementText();
+                    else if (name == "pubDate") newsItem.pubDate = xml.readElementText();
+                } else if (type == XmlType::WEATHER && name == "temperature") {
+                    items.append(TemperatureItem{xml.attributes().value("value").toString()});
+                } else if (type == XmlType::WEATHER && name == "feels_like") {
+                    items.append(FeelsLikeItem{xml.attributes().value("value").toString()});
+                } else if (type == XmlType::WEATHER && name == "weather") {
+                    items.append(WeatherItem{xml.attributes().value("value").toString()});
+                } else if (type == XmlType::FORECAST) {
+                    if (name == "maxtemp_c") forecastItem.maxTemp = xml.readElementText();
+                    else if (name == "mintemp_c") forecastItem.minTemp = xml.readElementText();
+                    else if (name == "date") forecastItem.date = xml.readElementText();
+                    else if (name == "daily_chance_of_rain") forecastItem.rainChance = xml.readElementText();
+                    else if (name == "icon") forecastItem.icon = xml.readElementText();
+                }
+            }
+        } else if (token == QXmlStreamReader::EndElement) {
+            QString name = xml.name().toString();
+
+            if ((name == LEGACY_TAGS.at(0) || (name == LEGACY_TAGS.at(1) && type == XmlType::WEATHER) || name == LEGACY_TAGS.at(3)) && inItem) {
+                inItem = false;
+                if (name == LEGACY_TAGS.at(0)) {
+                    items.append(newsItem);
+                } else if (name == LEGACY_TAGS.at(3)) {
+                    items.append(forecastItem);
+                }
+            }
+        }
+    }
+    return items.size();
+}
+
+int tableParse(const QByteArray &data, XmlType type)
+{
+    FeedParser parser(type);
+    if (parser.addData(data) == FeedParser::NeedMoreData) {
+        parser.finish();
+    }
+    return parser.takeResult().itemCount();
+}
+
+quint64 countTokens(const QByteArray &data)
+{
+    QXmlStreamReader xml(data);
+    quint64 tokens = 0;
+    while (!xml.atEnd()) {
+        xml.readNext();
+        tokens++;
+    }
+    return tokens;
+}
+
+struct Result {
+    double tokensPerSecond;
+    double allocationsPerDocument;
+    int items;
+};
+
+template <typename Parse>
+Result measure(const QByteArray &data, XmlType type, quint64 tokens, Parse parse)
+{
+    // Warm up, then count the allocations of a single document, including
+    // Qt's string and buffer storage
+    parse(data, type);
+    quint64 before = AllocationCounter::count();
+    int items = parse(data, type);
+    quint64 allocations = AllocationCounter::count() - before;
+
+    QElapsedTimer timer;
+    timer.start();
+    int iterations = 0;
+    while (iterations < MIN_ITERATIONS || timer.nsecsElapsed() < MIN_DURATION_NS) {
+        parse(data, type);
+        iterations++;
+    }
+    double seconds = timer.nsecsElapsed() / 1e9;
+
+    return {tokens * iterations / seconds, double(allocations), items};
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QString fixtureDir = app.arguments().size() > 1 ? app.arguments().at(1) : QString(BENCH_FIXTURE_DIR);
+
+    struct Fixture {
+        const char *file;
+        XmlType type;
+    };
+    const Fixture fixtures[] = {
+        {"bbc_world_rss.xml", XmlType::NEWS},
+        {"owm_current.xml", XmlType::WEATHER},
+        {"weatherapi_forecast.xml", XmlType::FORECAST}
+    };
+
+    QTextStream out(stdout);
+    out << "fixture,parser,items,tokens_per_second,allocations_per_document\n";
+
+    for (const Fixture &fixture : fixtures) {
+        QFile file(fixtureDir + "/" + fixture.file);
+        if (!file.open(QIODevice::ReadOnly)) {
+            qInfo() << "Cannot open fixture" << file.fileName();
+            return EXIT_FAILURE;
+        }
+        QByteArray data = file.readAll();
+        quint64 tokens = countTokens(data);
+
+        Result legacy = measure(data, fixture.type, tokens, legacyParse);
+        Result table = measure(data, fixture.type, tokens, tableParse);
+
+        out << fixture.file << ",legacy," << legacy.items << "," << qRound64(legacy.tokensPerSecond)
+            << "," << legacy.allocationsPerDocument << "\n";
+        out << fixture.file << ",table," << table.items << "," << qRound64(table.tokensPerSecond)
+            << "," << table.allocationsPerDocument << "\n";
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,233 @@
+// Offline benchmark of feed parsing against the recorded fixtures in
+// bench/fixtures, plus synthetic copies scaled to 10x and 100x the items.
+// Reports throughput, per-document latency percentiles and peak heap use,
+// and writes the results as JSON for regression tracking. Feeds the UI only
+// partly consumes are also parsed with the dashboard's field projection.
+//
+// Usage: PiDashboardBench [--fixtures dir] [--output file.json] [--duration ms]
+
+#include "FeedParser.h"
+#include "AllocationCounter.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+static const int MIN_ITERATIONS = 10;
+static const int DEFAULT_DURATION_MS = 1000;
+static const int CHUNK_SIZE = 4096;
+static const int SCALES[] = {1, 10, 100};
+
+struct Fixture {
+    const char *name;
+    const char *file;
+    XmlType type;
+    const char *element;
+    bool isRoot;
+    FeedFields projection;
+};
+
+// Projections are the ones the dashboard requests
+const Fixture FIXTURES[] = {
+    {"bbc_rss", "bbc_world_rss.xml", XmlType::NEWS, "item", false, NEWS_FIELDS},
+    {"owm_current", "owm_current.xml", XmlType::WEATHER, "current", true, ALL_FEED_FIELDS},
+    {"weatherapi_forecast", "weatherapi_forecast.xml", XmlType::FORECAST, "forecastday", false, ALL_FEED_FIELDS}
+};
+
+struct Mode {
+    const char *name;
+    int chunkSize;
+    bool projected;
+};
+
+const Mode MODES[] = {
+    {"whole", 0, false},
+    {"chunked", CHUNK_SIZE, false},
+    {"projected", 0, true}
+};
+
+// Repeats the span from the first <element> to the last </element> factor
+// times. A repeated root element gets wrapped so the document stays valid.
+QByteArray scaleDocument(const QByteArray &data, const QByteArray &element, bool isRoot, int factor)
+{
+    if (factor <= 1) {
+        return data;
+    }
+
+    int first = data.indexOf("<" + element + ">");
+    if (first < 0) {
+        first = data.indexOf("<" + element + " ");
+    }
+    const QByteArray closing = "</" + element + ">";
+    int last = data.lastIndexOf(closing);
+    if (first < 0 || last < first) {
+        return data;
+    }
+    last += closing.size();
+
+    QByteArray block = data.mid(first, last - first);
+    QByteArray scaled = data.left(first);
+    scaled.reserve(data.size() + block.size() * (factor - 1) + 32);
+    if (isRoot) {
+        scaled += "<scaled>";
+    }
+    for (int i = 0; i < factor; ++i) {
+        scaled += block;
+    }
+    if (isRoot) {
+        scaled += "</scaled>";
+    }
+    scaled += data.mid(last);
+    return scaled;
+}
+
+int parseDocument(const QByteArray &data, XmlType type, int chunkSize, FeedFields fields)
+{
+    FeedParser parser(type, 0, fields);
+    FeedParser::Status status = FeedParser::NeedMoreData;
+
+    if (chunkSize <= 0) {
+        status = parser.addData(data);
+    } else {
+        // Mimics QNetworkReply::readyRead delivering the body piecewise
+        for (int offset = 0; offset < data.size() && status == FeedParser::NeedMoreData; offset += chunkSize) {
+            status = parser.addData(QByteArray::fromRawData(data.constData() + offset,
+                                                            qMin(chunkSize, data.size() - offset)));
+        }
+    }
+
+    if (status == FeedParser::NeedMoreData) {
+        status = parser.finish();
+    }
+    return status == FeedParser::Error ? -1 : parser.takeResult().itemCount();
+}
+
+qint64 percentile(const std::vector<qint64> &sorted, double fraction)
+{
+    size_t index = size_t(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[qMin(index, sorted.size() - 1)];
+}
+
+QJsonObject runScenario(const Fixture &fixture, int scale, const Mode &mode, const QByteArray &data, qint64 durationNs)
+{
+    const FeedFields fields = mode.projected ? fixture.projection : ALL_FEED_FIELDS;
+
+    // One cold pass for item count, allocations and peak heap, counted at
+    // the malloc level so Qt's string and buffer storage is included
+    quint64 allocationsBefore = AllocationCounter::count();
+    quint64 liveBefore = AllocationCounter::liveBytes();
+    AllocationCounter::resetPeak();
+    int items = parseDocument(data, fixture.type, mode.chunkSize, fields);
+    quint64 allocations = AllocationCounter::count() - allocationsBefore;
+    quint64 peakBytes = AllocationCounter::peakBytes() - liveBefore;
+
+    std::vector<qint64> latencies;
+    QElapsedTimer total;
+    QElapsedTimer single;
+    total.start();
+    while (int(latencies.size()) < MIN_ITERATIONS || total.nsecsElapsed() < durationNs) {
+        single.start();
+        parseDocument(data, fixture.type, mode.chunkSize, fields);
+        latencies.push_back(single.nsecsElapsed());
+    }
+    double seconds = total.nsecsElapsed() / 1e9;
+    std::sort(latencies.begin(), latencies.end());
+
+    const double iterations = latencies.size();
+    QJsonObject result;
+    result["fixture"] = fixture.name;
+    result["scale"] = scale;
+    result["mode"] = mode.name;
+    result["bytes"] = data.size();
+    result["items"] = items;
+    result["iterations"] = int(iterations);
+    result["mb_per_second"] = data.size() * iterations / seconds / (1024.0 * 1024.0);
+    result["items_per_second"] = items * iterations / seconds;
+    result["latency_p50_us"] = percentile(latencies, 0.50) / 1000.0;
+    result["latency_p90_us"] = percentile(latencies, 0.90) / 1000.0;
+    result["latency_p99_us"] = percentile(latencies, 0.99) / 1000.0;
+    result["latency_max_us"] = latencies.back() / 1000.0;
+    result["allocations"] = double(allocations);
+    result["peak_heap_bytes"] = double(peakBytes);
+    return result;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser options;
+    options.addHelpOption();
+    options.addOption({"fixtures", "Directory with the recorded feed documents.", "dir", BENCH_FIXTURE_DIR});
+    options.addOption({"output", "Write the JSON results to file instead of stdout.", "file"});
+    options.addOption({"duration", "Minimum time spent per scenario in milliseconds.", "ms",
+                       QString::number(DEFAULT_DURATION_MS)});
+    options.process(app);
+
+    const qint64 durationNs = options.value("duration").toLongLong() * 1000 * 1000;
+    QJsonArray results;
+
+    for (const Fixture &fixture : FIXTURES) {
+        QFile file(options.value("fixtures") + "/" + fixture.file);
+        if (!file.open(QIODevice::ReadOnly)) {
+            qInfo() << "Cannot open fixture" << file.fileName();
+            return EXIT_FAILURE;
+        }
+        const QByteArray recorded = file.readAll();
+
+        for (int scale : SCALES) {
+            const QByteArray data = scaleDocument(recorded, fixture.element, fixture.isRoot, scale);
+
+            for (const Mode &mode : MODES) {
+                if (mode.projected && fixture.projection == ALL_FEED_FIELDS) {
+                    continue;
+                }
+                QJsonObject result = runScenario(fixture, scale, mode, data, durationNs);
+                if (result["items"].toInt() < 0) {
+                    qInfo() << "Fixture failed to parse:" << fixture.name << "x" << scale;
+                    return EXIT_FAILURE;
+                }
+
+                qInfo().noquote() << QString("%1 x%2 %3: %4 MB/s, p50 %5 us, p99 %6 us, peak %7 KB")
+                    .arg(fixture.name).arg(scale).arg(result["mode"].toString())
+                    .arg(result["mb_per_second"].toDouble(), 0, 'f', 2)
+                    .arg(result["latency_p50_us"].toDouble(), 0, 'f', 1)
+                    .arg(result["latency_p99_us"].toDouble(), 0, 'f', 1)
+                    .arg(result["peak_heap_bytes"].toDouble() / 1024.0, 0, 'f', 1);
+                results.append(result);
+            }
+        }
+    }
+
+    QJsonObject report;
+    report["benchmark"] = "PiDashboardBench";
+    report["version"] = 3;
+    report["allocation_counter"] = AllocationCounter::countsMalloc() ? "malloc" : "operator new";
+    report["results"] = results;
+    const QByteArray json = QJsonDocument(report).toJson();
+
+    if (options.isSet("output")) {
+        QFile output(options.value("output"));
+        if (!output.open(QIODevice::WriteOnly)) {
+            qInfo() << output.errorString();
+            return EXIT_FAILURE;
+        }
+        output.write(json);
+    } else {
+        QFile output;
+        output.open(stdout, QIODevice::WriteOnly);
+        output.write(json);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,264 @@
+// Long-run soak test of the real MainWindow on the offscreen platform.
+// Drives thousands of refresh cycles against a local FixtureServer, with a
+// simulated clock that advances a full refresh interval of one-second ticks
+// per cycle, so months of uptime take minutes. Every news refresh brings new
+// headlines. After each cycle deferred deletes are flushed and the heap,
+// resident memory and live QObjects are sampled. The per-cycle curve is
+// written as JSON, and the run fails if the steady-state growth (least
+// squares slope after the warm-up) exceeds the given thresholds.
+//
+// Usage: PiDashboardSoakBench [--fixtures dir] [--output file.json] [--cycles n]
+//            [--warmup n] [--ticks n] [--max-heap-growth kb] [--max-object-growth n]
+
+#include "AllocationCounter.h"
+#include "FixtureServer.h"
+#include "MainWindow.h"
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include <unistd.h>
+
+namespace {
+static const int DEFAULT_CYCLES = 2000;
+static const int DEFAULT_WARMUP = 200;
+// One 10 minute refresh interval
+static const int DEFAULT_TICKS = 600;
+// Growth allowed per 1000 cycles once warmed up
+static const int DEFAULT_MAX_HEAP_GROWTH_KB = 256;
+static const int DEFAULT_MAX_OBJECT_GROWTH = 5;
+static const int CYCLE_TIMEOUT_MS = 30 * 1000;
+
+struct Sample {
+    double heapBytes;
+    double rssBytes;
+    double objects;
+    double widgets;
+};
+
+// Bytes in use by malloc, which also covers Qt's containers; operator new
+// alone where glibc does not report it
+double heapBytes()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    return double(mallinfo2().uordblks);
+#else
+    return double(AllocationCounter::liveBytes());
+#endif
+}
+
+// Current resident set size from /proc, -1 where unavailable
+double residentBytes()
+{
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    return fields.size() > 1 ? fields.at(1).toDouble() * sysconf(_SC_PAGESIZE) : -1;
+}
+
+// Objects owned by the window and by the application (network stack, caches)
+int liveObjects(const QObject *window)
+{
+    return window->findChildren<QObject *>().size() + qApp->findChildren<QObject *>().size();
+}
+
+bool waitForContent(MainWindow &window)
+{
+    QEventLoop loop;
+    QTimer timeout;
+    timeout.setSingleShot(true);
+    QObject::connect(&timeout, &QTimer::timeout, &loop, [&loop]() { loop.exit(1); });
+    QObject::connect(&window, &MainWindow::contentComplete, &loop, [&loop]() { loop.exit(0); });
+    timeout.start(CYCLE_TIMEOUT_MS);
+    return loop.exec() == 0;
+}
+
+// Least squares slope of values[first..] per step
+double slope(const std::vector<Sample> &samples, size_t first, double Sample::*value)
+{
+    const size_t count = samples.size() - first;
+    if (count < 2) {
+        return 0;
+    }
+    double meanX = 0;
+    double meanY = 0;
+    for (size_t i = first; i < samples.size(); ++i) {
+        meanX += i;
+        meanY += samples[i].*value;
+    }
+    meanX /= count;
+    meanY /= count;
+
+    double covariance = 0;
+    double variance = 0;
+    for (size_t i = first; i < samples.size(); ++i) {
+        covariance += (i - meanX) * (samples[i].*value - meanY);
+        variance += (i - meanX) * (i - meanX);
+    }
+    return covariance / variance;
+}
+
+QJsonArray curve(const std::vector<Sample> &samples, double Sample::*value)
+{
+    QJsonArray values;
+    for (const Sample &sample : samples) {
+        values.append(sample.*value);
+    }
+    return values;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    // Before QApplication so no display is needed and no real cache is touched
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QTemporaryDir cacheHome;
+    qputenv("XDG_CACHE_HOME", cacheHome.path().toUtf8());
+
+    QApplication app(argc, argv);
+
+    QCommandLineParser options;
+    options.addHelpOption();
+    options.addOption({"fixtures", "Directory with the recorded feed documents.", "dir", BENCH_FIXTURE_DIR});
+    options.addOption({"output", "Write the JSON results to file instead of stdout.", "file"});
+    options.addOption({"cycles", "Number of refresh cycles.", "n", QString::number(DEFAULT_CYCLES)});
+    options.addOption({"warmup", "Cycles excluded from the growth estimate.", "n", QString::number(DEFAULT_WARMUP)});
+    options.addOption({"ticks", "Simulated clock seconds per cycle.", "n", QString::number(DEFAULT_TICKS)});
+    options.addOption({"max-heap-growth", "Allowed heap growth per 1000 cycles.", "kb",
+                       QString::number(DEFAULT_MAX_HEAP_GROWTH_KB)});
+    options.addOption({"max-object-growth", "Allowed QObject growth per 1000 cycles.", "n",
+                       QString::number(DEFAULT_MAX_OBJECT_GROWTH)});
+    options.process(app);
+
+    FixtureServer server;
+    if (!server.start(options.value("fixtures"))) {
+        return EXIT_FAILURE;
+    }
+
+    const QString base = server.baseUrl();
+    const std::map<QString, QString> envVars = {
+        {"ZIP", "00000,US"},
+        {"UNIT", "metric"},
+        {"OW_API_KEY", "soak"},
+        {"W_API_KEY", "soak"},
+        {"NEWS_URL", base + "/news.xml"},
+        {"WEATHER_URL", base + "/weather.xml"},
+        {"FORECAST_URL", base + "/forecast.xml"},
+        {"ICON_URL_PREFIX", base},
+        {"METRICS_PORT", "0"},
+        {"METRICS_DUMP_SECONDS", "0"},
+        // Thousands of cycles would exhaust any real daily quota
+        {"OW_DAILY_QUOTA", "0"},
+        {"W_DAILY_QUOTA", "0"}
+    };
+
+    // Outlives the window, whose clock reads it
+    QDateTime now = QDateTime::currentDateTime();
+    std::unique_ptr<MainWindow> window(new MainWindow(envVars));
+    window->setClock([&now]() { return now; });
+    window->show();
+    if (!waitForContent(*window)) {
+        qInfo() << "Start did not complete within" << CYCLE_TIMEOUT_MS << "ms";
+        return EXIT_FAILURE;
+    }
+
+    const int cycles = qMax(2, options.value("cycles").toInt());
+    const int warmup = qBound(0, options.value("warmup").toInt(), cycles - 2);
+    const int ticks = qMax(0, options.value("ticks").toInt());
+    std::vector<Sample> samples;
+    samples.reserve(size_t(cycles));
+
+    for (int cycle = 0; cycle < cycles; ++cycle) {
+        for (int i = 0; i < ticks; ++i) {
+            now = now.addSecs(1);
+            window->tick();
+        }
+
+        server.setNewsRevision(cycle + 1);
+        window->refreshNow();
+        if (!waitForContent(*window)) {
+            qInfo() << "Cycle" << cycle << "did not complete within" << CYCLE_TIMEOUT_MS << "ms";
+            return EXIT_FAILURE;
+        }
+        window->grab();
+
+        // Replies and downloaders are released with deleteLater
+        QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+        samples.push_back({heapBytes(), residentBytes(), double(liveObjects(window.get())),
+                           double(QApplication::allWidgets().size())});
+
+        if ((cycle + 1) % 100 == 0) {
+            qInfo().noquote() << QString("cycle %1: heap %2 KB, RSS %3 KB, %4 objects")
+                .arg(cycle + 1)
+                .arg(qRound64(samples.back().heapBytes / 1024))
+                .arg(qRound64(samples.back().rssBytes / 1024))
+                .arg(samples.back().objects);
+        }
+    }
+
+    // Growth per 1000 cycles over the steady state
+    const double heapGrowth = slope(samples, size_t(warmup), &Sample::heapBytes) * 1000;
+    const double rssGrowth = slope(samples, size_t(warmup), &Sample::rssBytes) * 1000;
+    const double objectGrowth = slope(samples, size_t(warmup), &Sample::objects) * 1000;
+    const double maxHeapGrowth = options.value("max-heap-growth").toDouble() * 1024;
+    const double maxObjectGrowth = options.value("max-object-growth").toDouble();
+    const bool passed = heapGrowth <= maxHeapGrowth && objectGrowth <= maxObjectGrowth;
+
+    qInfo().noquote() << QString("%1 cycles: heap %2 KB, RSS %3 KB, objects %4 per 1000 cycles, %5")
+        .arg(cycles)
+        .arg(heapGrowth / 1024, 0, 'f', 1)
+        .arg(rssGrowth / 1024, 0, 'f', 1)
+        .arg(objectGrowth, 0, 'f', 2)
+        .arg(passed ? "passed" : "FAILED");
+
+    QJsonObject report;
+    report["benchmark"] = "PiDashboardSoakBench";
+    report["version"] = 1;
+    report["cycles"] = cycles;
+    report["warmup_cycles"] = warmup;
+    report["ticks_per_cycle"] = ticks;
+    report["requests_served"] = server.requestsServed();
+    report["heap_growth_bytes_per_1000_cycles"] = heapGrowth;
+    report["rss_growth_bytes_per_1000_cycles"] = rssGrowth;
+    report["object_growth_per_1000_cycles"] = objectGrowth;
+    report["max_heap_growth_bytes_per_1000_cycles"] = maxHeapGrowth;
+    report["max_object_growth_per_1000_cycles"] = maxObjectGrowth;
+    report["passed"] = passed;
+    report["heap_bytes"] = curve(samples, &Sample::heapBytes);
+    report["rss_bytes"] = curve(samples, &Sample::rssBytes);
+    report["objects"] = curve(samples, &Sample::objects);
+    report["widgets"] = curve(samples, &Sample::widgets);
+    const QByteArray json = QJsonDocument(report).toJson();
+
+    if (options.isSet("output")) {
+        QFile output(options.value("output"));
+        if (!output.open(QIODevice::WriteOnly)) {
+            qInfo() << output.errorString();
+            return EXIT_FAILURE;
+        }
+        output.write(json);
+    } else {
+        QFile output;
+        output.open(stdout, QIODevice::WriteOnly);
+        output.write(json);
+    }
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,185 @@
+// End-to-end benchmark of the real MainWindow on the offscreen platform.
+// All feeds and icons come from a local FixtureServer, so the numbers do not
+// depend on the internet. Measures:
+//   - cold start: empty cache until news, weather, forecast and icons are
+//     shown and a full frame has been rendered
+//   - refresh: a forced fetch of every feed until the next full frame
+//   - warm start: a new window restoring the snapshot left by the first one
+//   - peak resident memory of the process
+// and writes the results as JSON.
+//
+// Usage: PiDashboardStartupBench [--fixtures dir] [--output file.json] [--cycles n]
+
+#include "FixtureServer.h"
+#include "MainWindow.h"
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace {
+static const int DEFAULT_CYCLES = 10;
+static const int FRAME_TIMEOUT_MS = 30 * 1000;
+
+// Peak resident set size from /proc, -1 where unavailable
+qint64 peakResidentBytes()
+{
+    QFile status("/proc/self/status");
+    if (!status.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    for (const QByteArray &line : status.readAll().split('\n')) {
+        if (line.startsWith("VmHWM:")) {
+            return line.mid(6).trimmed().split(' ').first().toLongLong() * 1024;
+        }
+    }
+    return -1;
+}
+
+// Waits for the next complete content update and renders a full frame.
+// Returns the elapsed time since timer was started, or -1 on timeout.
+double waitForFullFrame(MainWindow &window, const QElapsedTimer &timer)
+{
+    QEventLoop loop;
+    QTimer timeout;
+    timeout.setSingleShot(true);
+    QObject::connect(&timeout, &QTimer::timeout, &loop, [&loop]() { loop.exit(1); });
+    QObject::connect(&window, &MainWindow::contentComplete, &loop, [&loop]() { loop.exit(0); });
+    timeout.start(FRAME_TIMEOUT_MS);
+    if (loop.exec() != 0) {
+        return -1;
+    }
+
+    // Render everything the user would see on the next vsync
+    window.grab();
+    return timer.nsecsElapsed() / 1e6;
+}
+
+double median(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    return values.empty() ? 0 : values[values.size() / 2];
+}
+}
+
+int main(int argc, char *argv[])
+{
+    // Before QApplication so no display is needed and no real cache is touched
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QTemporaryDir cacheHome;
+    qputenv("XDG_CACHE_HOME", cacheHome.path().toUtf8());
+
+    QApplication app(argc, argv);
+
+    QCommandLineParser options;
+    options.addHelpOption();
+    options.addOption({"fixtures", "Directory with the recorded feed documents.", "dir", BENCH_FIXTURE_DIR});
+    options.addOption({"output", "Write the JSON results to file instead of stdout.", "file"});
+    options.addOption({"cycles", "Number of measured refresh cycles.", "n", QString::number(DEFAULT_CYCLES)});
+    options.process(app);
+
+    FixtureServer server;
+    if (!server.start(options.value("fixtures"))) {
+        return EXIT_FAILURE;
+    }
+
+    const QString base = server.baseUrl();
+    const std::map<QString, QString> envVars = {
+        {"ZIP", "00000,US"},
+        {"UNIT", "metric"},
+        {"OW_API_KEY", "bench"},
+        {"W_API_KEY", "bench"},
+        {"NEWS_URL", base + "/news.xml"},
+        {"WEATHER_URL", base + "/weather.xml"},
+        {"FORECAST_URL", base + "/forecast.xml"},
+        {"ICON_URL_PREFIX", base},
+        {"METRICS_PORT", "0"},
+        {"METRICS_DUMP_SECONDS", "0"}
+    };
+
+    QElapsedTimer timer;
+    timer.start();
+    std::unique_ptr<MainWindow> window(new MainWindow(envVars));
+    window->show();
+    const double coldStartMs = waitForFullFrame(*window, timer);
+    if (coldStartMs < 0) {
+        qInfo() << "Cold start did not complete within" << FRAME_TIMEOUT_MS << "ms";
+        return EXIT_FAILURE;
+    }
+
+    std::vector<double> refreshMs;
+    QJsonArray refreshes;
+    const int cycles = qMax(1, options.value("cycles").toInt());
+    for (int i = 0; i < cycles; ++i) {
+        timer.start();
+        window->refreshNow();
+        const double elapsed = waitForFullFrame(*window, timer);
+        if (elapsed < 0) {
+            qInfo() << "Refresh" << i << "did not complete within" << FRAME_TIMEOUT_MS << "ms";
+            return EXIT_FAILURE;
+        }
+        refreshMs.push_back(elapsed);
+        refreshes.append(elapsed);
+    }
+
+    // Destroying the window flushes the snapshot for the warm start
+    window.reset();
+
+    timer.start();
+    window.reset(new MainWindow(envVars));
+    window->show();
+    const double warmStartMs = waitForFullFrame(*window, timer);
+    window.reset();
+    if (warmStartMs < 0) {
+        qInfo() << "Warm start did not complete within" << FRAME_TIMEOUT_MS << "ms";
+        return EXIT_FAILURE;
+    }
+
+    const qint64 peakBytes = peakResidentBytes();
+    qInfo().noquote() << QString("cold start %1 ms, warm start %2 ms, refresh median %3 ms, peak RSS %4 KB")
+        .arg(coldStartMs, 0, 'f', 1)
+        .arg(warmStartMs, 0, 'f', 1)
+        .arg(median(refreshMs), 0, 'f', 1)
+        .arg(peakBytes / 1024);
+
+    QJsonObject report;
+    report["benchmark"] = "PiDashboardStartupBench";
+    report["version"] = 1;
+    report["cold_start_ms"] = coldStartMs;
+    report["warm_start_ms"] = warmStartMs;
+    report["refresh_median_ms"] = median(refreshMs);
+    report["refresh_max_ms"] = *std::max_element(refreshMs.begin(), refreshMs.end());
+    report["refresh_ms"] = refreshes;
+    report["requests_served"] = server.requestsServed();
+    report["peak_rss_bytes"] = double(peakBytes);
+    const QByteArray json = QJsonDocument(report).toJson();
+
+    if (options.isSet("output")) {
+        QFile output(options.value("output"));
+        if (!output.open(QIODevice::WriteOnly)) {
+            qInfo() << output.errorString();
+            return EXIT_FAILURE;
+        }
+        output.write(json);
+    } else {
+        QFile output;
+        output.open(stdout, QIODevice::WriteOnly);
+        output.write(json);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,113 @@
+// Benchmark of one SystemStats sample: wall time per sample and heap
+// allocations, against the recorded /proc and sysfs files in
+// bench/fixtures/system or, with --live, against this host.
+//
+// Usage: SystemStatsBench [--fixtures dir] [--live] [--samples n] [--output file.json]
+
+#include "SystemStats.h"
+#include "AllocationCounter.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+static const int DEFAULT_SAMPLES = 20000;
+static const int WARMUP_SAMPLES = 100;
+
+double percentile(const std::vector<qint64> &sorted, double fraction)
+{
+    return sorted[std::min(sorted.size() - 1, size_t(fraction * sorted.size()))] / 1000.0;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser options;
+    options.addHelpOption();
+    options.addOption({"fixtures", "Directory with the recorded system files.", "dir",
+                       QString(BENCH_FIXTURE_DIR) + "/system"});
+    options.addOption({"live", "Sample this host's /proc and sysfs instead of the fixtures."});
+    options.addOption({"samples", "Number of measured samples.", "n", QString::number(DEFAULT_SAMPLES)});
+    options.addOption({"output", "Write the JSON results to file instead of stdout.", "file"});
+    options.process(app);
+
+    SystemStatsSources sources;
+    if (!options.isSet("live")) {
+        const QString dir = options.value("fixtures");
+        sources.stat = dir + "/stat";
+        sources.meminfo = dir + "/meminfo";
+        sources.netDev = dir + "/net_dev";
+        sources.thermal = dir + "/thermal_temp";
+    }
+
+    SystemStats stats(sources);
+    QElapsedTimer clock;
+    clock.start();
+    SystemStats::Sample last;
+    for (int i = 0; i < WARMUP_SAMPLES; ++i) {
+        last = stats.sample(clock.nsecsElapsed());
+    }
+    if (last.memTotalKb < 0) {
+        qInfo() << "Cannot read the system sources";
+        return EXIT_FAILURE;
+    }
+
+    const int samples = qMax(1, options.value("samples").toInt());
+    std::vector<qint64> durations;
+    durations.reserve(samples);
+
+    const quint64 allocationsBefore = AllocationCounter::count();
+    for (int i = 0; i < samples; ++i) {
+        const qint64 start = clock.nsecsElapsed();
+        stats.sample(start);
+        durations.push_back(clock.nsecsElapsed() - start);
+    }
+    const quint64 allocations = AllocationCounter::count() - allocationsBefore;
+    std::sort(durations.begin(), durations.end());
+
+    qInfo().noquote() << QString("%1 samples: median %2 us, p99 %3 us, max %4 us, %5 allocations")
+        .arg(samples)
+        .arg(percentile(durations, 0.5), 0, 'f', 2)
+        .arg(percentile(durations, 0.99), 0, 'f', 2)
+        .arg(durations.back() / 1000.0, 0, 'f', 2)
+        .arg(allocations);
+
+    QJsonObject report;
+    report["benchmark"] = "SystemStatsBench";
+    report["version"] = 1;
+    report["source"] = options.isSet("live") ? "live" : "fixtures";
+    report["samples"] = samples;
+    report["median_us"] = percentile(durations, 0.5);
+    report["p99_us"] = percentile(durations, 0.99);
+    report["max_us"] = durations.back() / 1000.0;
+    report["allocations_per_sample"] = double(allocations) / samples;
+    report["cpu_load"] = last.cpuLoad;
+    report["mem_available_kb"] = double(last.memAvailableKb);
+    report["temperature_c"] = last.temperatureC;
+    const QByteArray json = QJsonDocument(report).toJson();
+
+    if (options.isSet("output")) {
+        QFile output(options.value("output"));
+        if (!output.open(QIODevice::WriteOnly)) {
+            qInfo() << output.errorString();
+            return EXIT_FAILURE;
+        }
+        output.write(json);
+    } else {
+        QFile output;
+        output.open(stdout, QIODevice::WriteOnly);
+        output.write(json);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -1,8 +1,14 @@
 #include "MainWindow.h"
+#include "EnvVars.h"
+#include "FeedFetcher.h"
+#include "FeedProtocol.h"
+#include "FeedPublisher.h"
+#include "NetworkService.h"
 
 #include <QApplication>
 #include <QTimer>
 #include <QFile>
+#include <memory>
 
 bool mapHasAllEntries(const QStringList &list, const std::map<QString, QString> &map) {
     for (const QString &key : list) {
@@ -15,16 +21,25 @@ bool mapHasAllEntries(const QStringList &list, const std::map<QString, QString>
 
 int main(int argc, char *argv[])
 {
-    QApplication a(argc, argv);
+    // The daemon only fetches and publishes, so it needs no display
+    const bool daemon = argc == 3 && qstrcmp(argv[1], "--daemon") == 0;
+    std::unique_ptr<QCoreApplication> a(daemon ? new QCoreApplication(argc, argv) : new QApplication(argc, argv));
 
     const QStringList REQUIRED_ENV_VARS = {"ZIP", "UNIT", "OW_API_KEY", "W_API_KEY"};
+    const QStringList OPTIONAL_ENV_VARS = {
+        "OW_DAILY_QUOTA", "W_DAILY_QUOTA", "METRICS_PORT", "METRICS_FILE", "METRICS_DUMP_SECONDS",
+        "TRACE_FILE", "NEWS_URL", "WEATHER_URL", "FORECAST_URL", "ICON_URL_PREFIX",
+        "FEED_SOCKET", "FEED_PORT", "FEED_SERVER", "IDLE_HOURS", "IDLE_POLL_MINUTES", "IDLE_BACKLIGHT",
+        "SYSTEM_STATS", "TEMPERATURE_HISTORY", "NETWORK_MODE", "NETWORK_ARCHIVE", "NETWORK_REPLAY_TIMING",
+        "NETWORK_LATENCY_MS", "NETWORK_BANDWIDTH_KBIT"
+    };
 
-    if (QCoreApplication::arguments().size() != 2) {
+    if (QCoreApplication::arguments().size() != (daemon ? 3 : 2)) {
         qInfo() << "Env file must be specified!";
         return EXIT_FAILURE;
     }
 
-    QFile envFile(QCoreApplication::arguments().at(1));
+    QFile envFile(QCoreApplication::arguments().last());
     if(!envFile.open(QIODevice::ReadOnly)) {
         qInfo() << envFile.errorString();
         return EXIT_FAILURE;
@@ -41,22 +56,46 @@ int main(int argc, char *argv[])
         line.remove("\"");
         line.remove("'");
 
-        QStringList list = line.split("=");
+        // Values such as URLs may contain '=' themselves
+        int separator = line.indexOf('=');
+        if (separator < 0) continue;
 
-        if (REQUIRED_ENV_VARS.contains(list[0])) {
-            envVars[list[0]] = list[1];
+        QString key = line.left(separator);
+        if (REQUIRED_ENV_VARS.contains(key) || OPTIONAL_ENV_VARS.contains(key)) {
+            envVars[key] = line.mid(separator + 1);
         }
     }
 
     envFile.close();
 
-    if (!mapHasAllEntries(REQUIRED_ENV_VARS, envVars)) {
+    // Screens fed by a daemon never contact the weather APIs themselves
+    const bool subscriber = !daemon && !envString(envVars, "FEED_SERVER", QString()).isEmpty();
+    if (!subscriber && !mapHasAllEntries(REQUIRED_ENV_VARS, envVars)) {
         qInfo() << "Missing required env variables!";
         return EXIT_FAILURE;
     }
 
+    // Before anything is fetched, so every request is recorded or replayed
+    NetworkService::instance()->configure(envVars);
+
+    if (daemon) {
+        FeedFetcher fetcher(envVars);
+        FeedPublisher publisher;
+        QObject::connect(&fetcher, &FeedFetcher::resultLoaded, &publisher, &FeedPublisher::publish);
+        publisher.setNewsSourceCount(fetcher.newsSourceCount());
+
+        const bool local = publisher.listenLocal(envString(envVars, "FEED_SOCKET", FeedProtocol::DEFAULT_SOCKET));
+        const bool tcp = publisher.listenTcp(envInt(envVars, "FEED_PORT", 0));
+        if (!local && !tcp) {
+            return EXIT_FAILURE;
+        }
+
+        fetcher.start();
+        return a->exec();
+    }
+
     MainWindow w(envVars);
     w.showFullScreen();
 
-    return a.exec();
+    return a->exec();
 }
@@ -0,0 +1,107 @@
+// Records the news feed through NetworkBackend from a slow local server, then
+// replays it with the server gone and checks the same headlines come back.
+// The reader stops at the item limit, which cancels the recorded download
+// part way, so the archive has to keep a response that never finished.
+
+#include "FixtureServer.h"
+#include "NetworkArchive.h"
+#include "NetworkService.h"
+#include "XmlReader.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QEventLoop>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <cstdlib>
+#include <memory>
+
+namespace {
+static const int NEWS_ITEMS = 8;
+static const int CHUNK_BYTES = 1024;
+static const int CHUNK_INTERVAL_MS = 10;
+static const int TIMEOUT_MS = 10 * 1000;
+
+// Headlines of one fetch, empty on failure
+QStringList fetchNews(const QUrl &url)
+{
+    XmlReader reader;
+    QEventLoop loop;
+    QTimer timeout;
+    timeout.setSingleShot(true);
+    QObject::connect(&timeout, &QTimer::timeout, &loop, [&loop]() { loop.exit(1); });
+    QObject::connect(&reader, &XmlReader::feedLoaded, &loop, [&loop]() { loop.exit(0); });
+    QObject::connect(&reader, &XmlReader::errorOccurred, &loop, [&loop](const QString &error) {
+        qInfo() << error;
+        loop.exit(1);
+    });
+    timeout.start(TIMEOUT_MS);
+    reader.loadFeed(url, XmlType::NEWS, NEWS_ITEMS, feedField(FeedTag::Title));
+    if (loop.exec() != 0 || !reader.getResult().news) {
+        return {};
+    }
+
+    QStringList titles;
+    for (const NewsItem &item : reader.getResult().news->items) {
+        titles.append(item.title);
+    }
+    return titles;
+}
+
+bool fail(const char *message)
+{
+    qInfo() << "FAIL:" << message;
+    return false;
+}
+
+bool recordThenReplay(const QString &archivePath)
+{
+    std::unique_ptr<FixtureServer> server(new FixtureServer);
+    if (!server->start(BENCH_FIXTURE_DIR)) {
+        return fail("fixture server did not start");
+    }
+    server->setChunking(CHUNK_BYTES, CHUNK_INTERVAL_MS);
+    const QUrl url(server->baseUrl() + "/news.xml");
+
+    NetworkService::instance()->configure({{"NETWORK_MODE", "record"}, {"NETWORK_ARCHIVE", archivePath}});
+    const QStringList recorded = fetchNews(url);
+    if (recorded.size() != NEWS_ITEMS) {
+        return fail("recording did not parse the news feed");
+    }
+
+    NetworkArchive archive;
+    if (!archive.load(archivePath) || archive.size() != 1) {
+        return fail("the news response was not archived");
+    }
+    const NetworkArchive::Entry *entry = archive.next(url, false);
+    if (!entry || !entry->truncated) {
+        return fail("the download was not cut short at the item limit");
+    }
+
+    // Nothing may reach the network from here on
+    server.reset();
+    NetworkService::instance()->configure({{"NETWORK_MODE", "replay"}, {"NETWORK_ARCHIVE", archivePath},
+                                           {"NETWORK_REPLAY_TIMING", "0"}});
+    const QStringList replayed = fetchNews(url);
+    if (replayed != recorded) {
+        qInfo() << "recorded" << recorded << "replayed" << replayed;
+        return fail("replay did not serve the recorded headlines");
+    }
+    return true;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    // Before the application so no real cache is touched
+    QTemporaryDir cacheHome;
+    qputenv("XDG_CACHE_HOME", cacheHome.path().toUtf8());
+
+    QCoreApplication app(argc, argv);
+
+    if (!recordThenReplay(cacheHome.path() + "/network.archive")) {
+        return EXIT_FAILURE;
+    }
+    qInfo() << "PASS";
+    return EXIT_SUCCESS;
+}
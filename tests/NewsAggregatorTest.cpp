@@ -0,0 +1,70 @@
+// Checks that a story whose title was edited stays one headline when the
+// sources disagree on the title but share its GUID.
+
+#include "NewsAggregator.h"
+
+#include <QDebug>
+#include <cstdlib>
+
+namespace {
+static const int SLOTS = 8;
+static const char *GUID = "https://www.bbc.co.uk/news/world-1";
+static const char *OLD_TITLE = "Storm nears the coast";
+static const char *NEW_TITLE = "Storm makes landfall on the coast";
+
+NewsFeed feedOf(const QString &title, const QString &guid)
+{
+    NewsItem item;
+    item.title = title;
+    item.guid = guid;
+    item.pubDate = "Sun, 18 Oct 2026 08:00:00 GMT";
+    NewsFeed feed;
+    feed.items.push_back(item);
+    return feed;
+}
+
+bool expectOneHeadline(const NewsAggregator &news, const QString &title, const char *scenario)
+{
+    const auto headlines = news.headlines();
+    QStringList titles;
+    for (const NewsItem &item : headlines->items) {
+        titles.append(item.title);
+    }
+    if (titles != QStringList{title}) {
+        qInfo() << "FAIL:" << scenario << "expected" << title << "got" << titles;
+        return false;
+    }
+    return true;
+}
+
+// One source still has the old title, the other already the new one
+bool bothCarryGuid()
+{
+    NewsAggregator news(SLOTS);
+    news.update(0, feedOf(OLD_TITLE, GUID));
+    news.update(1, feedOf(NEW_TITLE, GUID));
+    return expectOneHeadline(news, NEW_TITLE, "both sources carry the GUID");
+}
+
+// The new title was first seen without a GUID, then the GUID joins it while
+// the other source still carries the old title
+bool guidJoinsEditedTitle()
+{
+    NewsAggregator news(SLOTS);
+    news.update(0, feedOf(OLD_TITLE, GUID));
+    news.update(1, feedOf(NEW_TITLE, QString()));
+    news.update(1, feedOf(NEW_TITLE, GUID));
+    return expectOneHeadline(news, NEW_TITLE, "GUID joins the edited title");
+}
+}
+
+int main()
+{
+    bool passed = bothCarryGuid();
+    passed = guidJoinsEditedTitle() && passed;
+    if (!passed) {
+        return EXIT_FAILURE;
+    }
+    qInfo() << "PASS";
+    return EXIT_SUCCESS;
+}
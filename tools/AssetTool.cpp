@@ -0,0 +1,90 @@
+// Build-time asset stage. Decodes the background once, scales it to each
+// display resolution and writes the pixels as a C++ source, so at runtime
+// the image is mapped from the executable straight into a QImage with no
+// JPEG decode or scaling.
+//
+// Usage: PiDashboardAssetTool background.jpg output.cpp 800x480 [1024x600 ...]
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFileInfo>
+#include <QImage>
+#include <QSaveFile>
+#include <QSize>
+#include <QStringList>
+#include <cstdlib>
+
+namespace {
+static const int VALUES_PER_LINE = 32;
+
+QSize parseSize(const QString &text)
+{
+    const QStringList parts = text.split('x');
+    if (parts.size() != 2) {
+        return QSize();
+    }
+    return QSize(parts[0].toInt(), parts[1].toInt());
+}
+
+void appendPixels(QByteArray *out, const QImage &image, const QByteArray &name)
+{
+    // Aligned so QImage can use the data in place
+    *out += "alignas(64) const uchar " + name + "[] = {\n";
+    const int bytes = image.sizeInBytes();
+    const uchar *pixels = image.constBits();
+    for (int i = 0; i < bytes; ++i) {
+        *out += QByteArray::number(pixels[i]);
+        *out += (i + 1) % VALUES_PER_LINE == 0 ? ",\n" : ",";
+    }
+    *out += "\n};\n\n";
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    if (args.size() < 4) {
+        qInfo() << "Usage: PiDashboardAssetTool background.jpg output.cpp WIDTHxHEIGHT...";
+        return EXIT_FAILURE;
+    }
+
+    const QImage source(args[1]);
+    if (source.isNull()) {
+        qInfo() << "Cannot decode" << args[1];
+        return EXIT_FAILURE;
+    }
+
+    QByteArray out;
+    out.reserve(8 * 1024 * 1024);
+    out += "// Generated by PiDashboardAssetTool from " + QFileInfo(args[1]).fileName().toUtf8() + ", do not edit\n"
+           "#include \"BackgroundAssets.h\"\n\n"
+           "namespace {\n";
+
+    QByteArray table;
+    for (int i = 3; i < args.size(); ++i) {
+        const QSize size = parseSize(args[i]);
+        if (size.isEmpty()) {
+            qInfo() << "Invalid display size" << args[i];
+            return EXIT_FAILURE;
+        }
+
+        // Same scaling as the runtime fallback, once, in the format painted fastest
+        const QImage scaled = source.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+                                  .convertToFormat(QImage::Format_RGB32);
+        const QByteArray name = "BACKGROUND_" + QByteArray::number(size.width()) + "X" + QByteArray::number(size.height());
+        appendPixels(&out, scaled, name);
+        table += "    {" + QByteArray::number(size.width()) + ", " + QByteArray::number(size.height()) + ", " + name + "},\n";
+    }
+
+    out += "}\n\n"
+           "const BackgroundAsset BACKGROUND_ASSETS[] = {\n" + table + "    {0, 0, nullptr}\n};\n";
+
+    QSaveFile file(args[2]);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qInfo() << file.errorString();
+        return EXIT_FAILURE;
+    }
+    file.write(out);
+    return file.commit() ? EXIT_SUCCESS : EXIT_FAILURE;
+}